@@ -7,318 +7,155 @@
 #include <cstdint>
 #include <filesystem>
 #include <thread>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include "core/compression/gr_lzss.h"
+#include "core/compression/gr_checkpoint.h"
+#include "core/encryption/eagls_cipher.h"
 namespace fs = std::filesystem;
 
-const char* EaglsKey = "EAGLS_SYSTEM";
-
-class LehmerRandomGenerator {
-public:
-    LehmerRandomGenerator() : m_seed(0) {}
-
-    void srand(int32_t seed) {
-        m_seed = seed ^ 123459876;
-    }
-
-    int32_t rand() {
-        m_seed = (48271 * (m_seed % 44488) - 3399 * (m_seed / 44488));
-        if (m_seed < 0) {
-            m_seed += 2147483647;
-        }
-        return m_seed * 4.656612875245797e-10 * 256;
-    }
-
-private:
-    int32_t m_seed;
-};
-
 void DecryptCg(std::vector<unsigned char>& data) {
-    LehmerRandomGenerator rng;
-    rng.srand(data.back());
-    size_t limit = data.size() - 1;
-    if (limit > 0x174b)
-        limit = 0x174b;
-    for (size_t i = 0; i < limit; ++i) {
-        data[i] ^= EaglsKey[rng.rand() % 12];
-    }
+    if (data.empty())
+        return;
+    eagls::encryption::cipher::GrCipher::apply(data.data(), data.size() - 1, data.back());
 }
 
-void make_next(const std::vector<char>& pattern, int* next, int size)
-{
-    next[0] = -1;
-    int j = 0;
-    int k = -1;
-    while (j < size)
-    {
-        if (k == -1 || pattern[j] == pattern[k])
-        {
-            j++;
-            k++;
-            next[j] = k;
-        }
-        else
-            k = next[k];
-    }
-}
-
-std::vector<char> LZSS_encode_kmp(const std::vector<char>& data) {
-
-    const int max_buflen = 18;
-
-    int i = 0;
-    int size = data.size();
-
-    std::vector<char> output;
-    output.reserve(size);
-
-    char frame[0x1000] = { 0 };
-    int frame_pos = 0xfee;
-    int frame_mask = 0x1000 - 1;
-    int itemnum = 0;
-    char signbits = 0;
-
-    int* kmp_next = new int[size];
-
-    std::vector<char> restorebuff;  // 待写入的数据缓存区，满一组数据写入一次文件
-    make_next(data, kmp_next, size);
-    while (i < size)
-    {
-
-        //find
-        int max_length = -1;
-        int max_id = -1;
-        int j = 1;
-        int k = -1;
-        while (j <= 0x1000 && k < max_buflen && i + k < size)
-        {
-            int frame_pos_i = (j + frame_pos) & frame_mask;
-            if (k == -1 || frame[frame_pos_i] == data[i + k])
-            {
-                j++;
-                k++;
-            }
-            else
-            {
-                if (k > max_length)
-                {
-                    max_length = k;
-                    max_id = (j + frame_pos - k - 1) & frame_mask;
-                }
-                k = kmp_next[i + k] - i;
-                if (k < 0)
-                    k = -1;
-            }
-            /*for (; k < max_buflen && i + k < size; k++)
-            {
-                int frame_pos_i = (j + frame_pos + k) & frame_mask;
-                if (frame[frame_pos_i] != data[i + k])
-                {
-                    if (j == 0x1000 && k > 0 && data[i] == data[i + k])
-                    {
-                        int j = 1;
-                        for (; k + j < max_buflen && i + k + j < size; j++)
-                        {
-                            if (data[i + j] != data[i + k + j])
-                            {
-                                break;
-                            }
-                        }
-                        k += j;
-                    }
-                    break;
-                }
-            }
-            if (k > 2 && k > max_length)
-            {
-                max_length = k;
-                max_id = (j + frame_pos - 1) & frame_mask;
-            }
-            if (max_length == max_buflen)
-                break;*/
-        }
-        if (k > max_length)
-        {
-            max_length = k;
-            max_id = (j + frame_pos - k - 1) & frame_mask;
-        }
-
-        // match
-        if (max_length < 3)
-        {
-            restorebuff.push_back(data[i]);
-            signbits += (1 << itemnum);
-        }
-        else
-        {
-            restorebuff.push_back(max_id & 0xff);
-            restorebuff.push_back(((max_id >> 4) & 0xf0) + (max_length - 3));
-        }
-        itemnum += 1;
-
-        // 项目数达到8了，说明做完了一组压缩，将这一组数据写入文件
-        if (itemnum >= 8) {
-            std::vector<char> writebytes = { signbits };
-            writebytes.insert(writebytes.end(), restorebuff.begin(), restorebuff.end());
-            output.insert(output.end(), writebytes.begin(), writebytes.end());
-            itemnum = 0;
-            signbits = 0;
-            restorebuff.clear();
-        }
-        if (false)
-        {
-            for (int j = 0; j < max_length; j++) {
-                frame_pos += 1;
-                frame_pos &= frame_mask;
-                frame[frame_pos] = data[i + j];
-            }
-            i += max_length;
-        }
-        else
-        {
-            frame_pos += 1;
-            frame_pos &= frame_mask;
-            frame[frame_pos] = data[i];
-            i += 1;
-        }
-    }
-    if (!restorebuff.empty()) {  // 文件最后可能不满一组数据量，直接写到文件里
-        std::vector<char> writebytes = { signbits };
-        writebytes.insert(writebytes.end(), restorebuff.begin(), restorebuff.end());
-        output.insert(output.end(), writebytes.begin(), writebytes.end());
-    }
-    delete[] kmp_next;
-    return output;
-}
-
-std::vector<unsigned char> LZSS_encode(const std::vector<unsigned char>& data) {
-
-    const int max_buflen = 18;
-    int size = data.size();
-
-    std::vector<unsigned char> output;
-    output.reserve(size);
-
-    unsigned char frame[0x1000] = { 0 };
-    int frame_pos = 0xfee;
-    int frame_mask = 0x1000 - 1;
-    int itemnum = 0;
-    unsigned char signbits = 0;
-    std::vector<unsigned char> restorebuff;  // 待写入的数据缓存区，满一组数据写入一次文件
-    int i = 0;
-    while (i < size)
-    {
-        //find
-        int max_length = -1;
-        int max_id = -1;
-        for (int j = 1; j < 0x1000; j++)
-        {
-            // break;
-            if (i < 0x12 && (((j + frame_pos - 1) & frame_mask) >= 0xfee))
-                break;
-            int k = 0;
-            for (; k < max_buflen && i + k < size; k++)
-            {
-                if (j + k >= 0x1000 && j + k - 0x1000 < k)
-                {
-                    break;
-                    if (data[i + j + k - 0x1000 - 1] != data[i + k])
-                    {
-                        break;
-                    }
-                }
-                else
-                {
-                    int frame_pos_i = (j + frame_pos + k) & frame_mask;
-                    if (frame[frame_pos_i] != data[i + k])
-                    {
-                        break;
-                    }
-                }
-            }
-            if (k > 2 && k > max_length)
-            {
-                max_length = k;
-                max_id = (j + frame_pos - 1) & frame_mask;
-            }
-            if (max_length == max_buflen)
-                break;
-        }
-
-        // match
-        if (max_length == -1)
-        {
-            restorebuff.push_back(data[i]);
-            signbits += (1 << itemnum);
-        }
-        else
-        {
-            restorebuff.push_back(max_id & 0xff);
-            restorebuff.push_back(((max_id >> 4) & 0xf0) + (max_length - 3));
-        }
-        itemnum += 1;
-
-        // 项目数达到8了，说明做完了一组压缩，将这一组数据写入文件
-        if (itemnum >= 8) {
-            std::vector<unsigned char> writebytes = { signbits };
-            writebytes.insert(writebytes.end(), restorebuff.begin(), restorebuff.end());
-            output.insert(output.end(), writebytes.begin(), writebytes.end());
-            itemnum = 0;
-            signbits = 0;
-            restorebuff.clear();
-        }
-        if (max_length > 0)
-        {
-            for (int j = 0; j < max_length; j++) {
-                frame_pos += 1;
-                frame_pos &= frame_mask;
-                frame[frame_pos] = data[i + j];
-            }
-            i += max_length;
-        }
-        else
-        {
-            frame_pos += 1;
-            frame_pos &= frame_mask;
-            frame[frame_pos] = data[i];
-            i += 1;
-        }
-    }
-    if (!restorebuff.empty()) {  // 文件最后可能不满一组数据量，直接写到文件里
-        std::vector<unsigned char> writebytes = { signbits };
-        writebytes.insert(writebytes.end(), restorebuff.begin(), restorebuff.end());
-        output.insert(output.end(), writebytes.begin(), writebytes.end());
-    }
-
-    return output;
-}
-
-void decode(const std::string infile, const std::string outfile, bool decrypt=true)
+void decode(const std::string infile, const std::string outfile, bool decrypt=true, int encodeThreads=1,
+            eagls::compression::GrLevel level=eagls::compression::GrLevel::Greedy, size_t checkpointInterval=0,
+            bool windowScan=false)
 {
     std::ifstream input(infile, std::ios::binary);
     std::vector<unsigned char> buffer(std::istreambuf_iterator<char>(input), {});
     input.close();
-    std::vector<unsigned char> compresseddata = LZSS_encode(buffer);
+    eagls::compression::GrLzss lzss;
+    lzss.setThreadCount(encodeThreads);
+    lzss.setLevel(level);
+    if (windowScan)
+        lzss.setMatchFinder(eagls::compression::GrMatchFinder::WindowScan);
+    std::vector<unsigned char> compresseddata = lzss.encode(buffer);
+    if (checkpointInterval > 0) {
+        // 检查点索引针对加密前的压缩数据，保存在GR文件旁
+        eagls::compression::GrCheckpointIndex index;
+        if (index.build(compresseddata.data(), compresseddata.size(), checkpointInterval))
+            index.save(eagls::compression::GrCheckpointIndex::getIndexFilename(outfile));
+    }
     if (decrypt)
         DecryptCg(compresseddata);
 
+    eagls::compression::GrEncodeStats stats = lzss.getLastStats();
+    double ratio = stats.inputSize ? 100.0 * stats.outputSize / stats.inputSize : 0.0;
+    std::ostringstream report;
+    report << fs::path(infile).filename().string() << ": " << stats.inputSize << " -> " << stats.outputSize
+           << " bytes (" << std::fixed << std::setprecision(1) << ratio << "%), " << stats.elapsedMs << " ms\n";
+    std::cout << report.str();
+
     std::ofstream output(outfile, std::ios::binary);
     auto res = compresseddata.data();
     output.write(reinterpret_cast<char*>(compresseddata.data()), compresseddata.size());
     output.close();
 }
 
+// 解析压缩级别名称，未知名称输出错误并返回false
+bool parseLevel(const std::string& name, eagls::compression::GrLevel& level) {
+    if (name == "store")
+        level = eagls::compression::GrLevel::Store;
+    else if (name == "greedy")
+        level = eagls::compression::GrLevel::Greedy;
+    else if (name == "bitmap")
+        level = eagls::compression::GrLevel::Bitmap;
+    else if (name == "optimal")
+        level = eagls::compression::GrLevel::Optimal;
+    else if (name == "original")
+        level = eagls::compression::GrLevel::Original;
+    else {
+        std::cerr << "Error: unknown compression level: " << name << " (store|greedy|bitmap|optimal|original)\n";
+        return false;
+    }
+    return true;
+}
+
+// 对目录中未加密的GR文件做 解压->重新压缩，统计与原文件逐字节相同的比例
+int verifyRoundTrip(const std::string& folder, eagls::compression::GrLevel level)
+{
+    size_t total = 0;
+    size_t identical = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(folder)) {
+        if (!entry.is_regular_file())
+            continue;
+        std::ifstream input(entry.path(), std::ios::binary);
+        std::vector<unsigned char> original(std::istreambuf_iterator<char>(input), {});
+        input.close();
+
+        eagls::compression::GrLzss lzss;
+        lzss.setLevel(level);
+        std::vector<unsigned char> reencoded = lzss.encode(lzss.decode(original));
+
+        ++total;
+        std::string name = entry.path().filename().string();
+        if (reencoded == original) {
+            ++identical;
+            std::cout << name << ": identical\n";
+        } else {
+            size_t diff = std::mismatch(original.begin(), original.begin() + std::min(original.size(), reencoded.size()),
+                                        reencoded.begin()).first - original.begin();
+            std::cout << name << ": differs at byte " << diff << " (" << original.size() << " -> " << reencoded.size() << " bytes)\n";
+        }
+    }
+    double percent = total ? 100.0 * identical / total : 0.0;
+    std::cout << identical << "/" << total << " bit-identical (" << std::fixed << std::setprecision(1) << percent << "%)\n";
+    return identical == total ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
+    // --verify <GR目录> [-l level]: 检查解压后重新压缩是否与原文件相同，默认使用original级别
+    if (argc > 2 && std::string(argv[1]) == "--verify") {
+        eagls::compression::GrLevel verifyLevel = eagls::compression::GrLevel::Original;
+        if (argc > 4 && (std::string(argv[3]) == "-l" || std::string(argv[3]) == "--level") &&
+            !parseLevel(argv[4], verifyLevel))
+            return 1;
+        return verifyRoundTrip(argv[2], verifyLevel);
+    }
     std::string folder = argv[1];
     std::string outfolder = argv[2];
     bool decrypt = true;
     if (argc > 2 && argv[3] == "1")
         decrypt = false;
+    // -j/--threads N: 逐个文件压缩，每个文件内部用N个线程并行查找匹配（0表示全部核心）
+    // -l/--level store|greedy|bitmap|optimal|original: 压缩级别
+    // --window-scan: optimal级别改用向量化整窗口查找最长匹配
+    // -c/--checkpoints KB: 每隔KB千字节生成一个解压检查点，写入<输出文件>.grx
+    int encodeThreads = -1;
+    eagls::compression::GrLevel level = eagls::compression::GrLevel::Greedy;
+    size_t checkpointInterval = 0;
+    bool windowScan = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--window-scan") {
+            windowScan = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            break;
+        if (arg == "-j" || arg == "--threads")
+            encodeThreads = std::stoi(argv[++i]);
+        else if (arg == "-l" || arg == "--level") {
+            if (!parseLevel(argv[++i], level))
+                return 1;
+        }
+        else if (arg == "-c" || arg == "--checkpoints")
+            checkpointInterval = std::stoul(argv[++i]) * 1024;
+    }
     std::filesystem::create_directory(outfolder);
     std::vector<std::thread> threads;
     for (const auto& entry : std::filesystem::directory_iterator(folder)) {
         auto path = entry.path();
         std::string infile = path.string();
         std::string outfile = outfolder + "/" + path.replace_extension(".gr").filename().string();
-        threads.push_back(std::thread(decode, infile, outfile, false));
+        if (encodeThreads >= 0)
+            decode(infile, outfile, false, encodeThreads, level, checkpointInterval, windowScan);
+        else
+            threads.push_back(std::thread(decode, infile, outfile, false, 1, level, checkpointInterval, windowScan));
     }
     for (auto& t : threads) {
         t.join();
@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "core/compression/gr_lzss.h"
+
+namespace eagls {
+namespace compression {
+
+/**
+ * @brief GR解压检查点
+ *
+ * 记录某个项目边界处的完整解压状态，从这里可以直接继续解压而不必从头开始。
+ */
+struct EAGLS_COMPRESSION_API GrCheckpoint {
+    uint64_t outputOffset;   // 解压后的偏移
+    uint64_t inputOffset;    // 压缩数据中下一个要读取的字节偏移
+    uint8_t flags;           // 当前组的标记字节
+    uint8_t itemIndex;       // 组内下一个项目的序号，8表示下一个字节是新的标记字节
+    uint8_t frame[GrLzss::FRAME_SIZE];  // 此时的4KB帧快照
+};
+
+/**
+ * @brief GR检查点索引
+ *
+ * 每隔固定的解压字节数保存一个检查点，保存为GR文件旁的独立文件（扩展名.grx），
+ * 不改变游戏使用的GR/PAK格式。索引针对未加密的压缩数据。
+ * 有了索引就可以把一张图分给多个线程同时解压，或只解压其中一段（如预览所需的几行）。
+ */
+class EAGLS_COMPRESSION_API GrCheckpointIndex {
+public:
+    static constexpr size_t DEFAULT_INTERVAL = 256 * 1024;  // 默认检查点间隔
+
+    /**
+     * @brief 构造函数
+     */
+    GrCheckpointIndex();
+
+    /**
+     * @brief 扫描压缩数据生成检查点
+     * @param src 压缩数据
+     * @param srcSize 压缩数据大小
+     * @param interval 检查点间隔（解压后的字节数）
+     * @return 是否成功
+     */
+    bool build(const uint8_t* src, size_t srcSize, size_t interval = DEFAULT_INTERVAL);
+
+    /**
+     * @brief 保存索引文件
+     * @param filename 索引文件名
+     * @return 是否成功
+     */
+    bool save(const std::string& filename) const;
+
+    /**
+     * @brief 读取索引文件
+     * @param filename 索引文件名
+     * @return 是否成功
+     */
+    bool load(const std::string& filename);
+
+    /**
+     * @brief 解压指定范围
+     *
+     * 从不超过起始偏移的最近检查点开始解压，范围跨越多个检查点时按检查点分段并行解压。
+     * @param src 压缩数据（必须与生成索引时的数据相同）
+     * @param srcSize 压缩数据大小
+     * @param outputOffset 解压后的起始偏移
+     * @param dst 输出缓冲区
+     * @param dstSize 要解压的字节数
+     * @param threadCount 线程数，0表示使用全部硬件线程
+     * @return 实际写入的字节数
+     */
+    size_t decodeRange(const uint8_t* src, size_t srcSize, size_t outputOffset,
+                       uint8_t* dst, size_t dstSize, int threadCount = 1) const;
+
+    /**
+     * @brief 获取解压后的总大小
+     * @return 解压后的字节数
+     */
+    size_t getDecodedSize() const;
+
+    /**
+     * @brief 获取检查点列表
+     * @return 检查点列表
+     */
+    const std::vector<GrCheckpoint>& getCheckpoints() const;
+
+    /**
+     * @brief 获取GR文件对应的索引文件名
+     * @param grFilename GR文件名
+     * @return 索引文件名
+     */
+    static std::string getIndexFilename(const std::string& grFilename);
+
+private:
+    size_t m_interval;                       // 检查点间隔
+    uint64_t m_decodedSize;                  // 解压后的大小
+    uint64_t m_compressedSize;               // 压缩数据大小
+    std::vector<GrCheckpoint> m_checkpoints; // 检查点
+};
+
+} // namespace compression
+} // namespace eagls
@@ -0,0 +1,234 @@
+﻿#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_COMPRESSION_EXPORTS
+        #define EAGLS_COMPRESSION_API __declspec(dllexport)
+    #elif defined(EAGLS_COMPRESSION_STATIC)
+        #define EAGLS_COMPRESSION_API
+    #else
+        #define EAGLS_COMPRESSION_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_COMPRESSION_API
+#endif
+
+namespace eagls {
+namespace compression {
+
+/**
+ * @brief GR压缩级别
+ */
+enum class GrLevel {
+    Store,    // 全部作为原始字节输出，不查找匹配，速度接近内存复制，游戏仍可正常解压
+    Greedy,   // 哈希链查找 + 贪心解析（默认）
+    Optimal,  // 完整窗口查找 + 最小输出的最优解析
+    Original, // 复现原版编码器（Okumura二叉树LZSS）的解析，单线程
+    Bitmap,   // 按BMP头的行距先探测上一行/上一像素/最近距离，再查哈希链，单线程；非BMP数据按Greedy处理
+};
+
+/**
+ * @brief 最优解析使用的最长匹配查找方式
+ */
+enum class GrMatchFinder {
+    HashChain,   // 走完整条哈希链（默认）
+    WindowScan,  // 哈希链过长时改为向量化（AVX2/SSE2，运行时选择）比较整个4KB窗口，适合大量重复短模式的数据
+};
+
+/**
+ * @brief 最近一次压缩的统计信息
+ */
+struct EAGLS_COMPRESSION_API GrEncodeStats {
+    size_t inputSize;    // 输入字节数
+    size_t outputSize;   // 输出字节数
+    double elapsedMs;    // 耗时（毫秒）
+};
+
+/**
+ * @brief GR图像使用的LZSS编解码器
+ *
+ * 与游戏一致的帧格式：4KB环形帧初始全为0，写入位置从0xfee开始；
+ * 标记字节按低位优先，位为1表示原始字节；
+ * 匹配项为2字节，12位帧偏移 + 4位(长度-3)，长度范围3~18。
+ */
+class EAGLS_COMPRESSION_API GrLzss {
+public:
+    static constexpr size_t FRAME_SIZE = 0x1000;      // 环形帧大小
+    static constexpr size_t FRAME_MASK = FRAME_SIZE - 1;
+    static constexpr size_t FRAME_INIT_POS = 0xfee;   // 初始写入位置
+    static constexpr size_t MIN_MATCH = 3;            // 最短匹配长度
+    static constexpr size_t MAX_MATCH = 18;           // 最长匹配长度
+
+    /**
+     * @brief 构造函数
+     * @param maxChainDepth 每个位置最多检查的哈希链候选数（越大压缩率越高、速度越慢）
+     */
+    explicit GrLzss(int maxChainDepth = 256);
+
+    /**
+     * @brief 设置压缩使用的线程数
+     *
+     * 输入被切分为多个块并行查找匹配，再顺序拼接解析结果；
+     * 输出与单线程压缩逐字节相同。
+     * @param threadCount 线程数，0表示使用全部硬件线程
+     */
+    void setThreadCount(int threadCount);
+
+    /**
+     * @brief 设置压缩级别
+     * @param level 压缩级别
+     */
+    void setLevel(GrLevel level);
+
+    /**
+     * @brief 设置最优解析使用的最长匹配查找方式
+     *
+     * 两种方式都得到窗口内的最长匹配，输出大小相同，只影响速度。
+     * @param matchFinder 查找方式
+     */
+    void setMatchFinder(GrMatchFinder matchFinder);
+
+    /**
+     * @brief 获取最近一次压缩的统计信息
+     * @return 输入/输出大小与耗时
+     */
+    GrEncodeStats getLastStats() const;
+
+    /**
+     * @brief 压缩数据
+     * @param data 要压缩的数据
+     * @return 压缩后的数据
+     */
+    std::vector<uint8_t> encode(const std::vector<uint8_t>& data);
+
+    /**
+     * @brief 解压数据
+     * @param data 要解压的数据
+     * @return 解压后的数据
+     */
+    std::vector<uint8_t> decode(const std::vector<uint8_t>& data);
+
+    /**
+     * @brief 解压到调用者提供的缓冲区
+     *
+     * 直接以输出缓冲区作为历史窗口，不需要单独的帧；
+     * 输出缓冲区写满即停止，因此只解出BMP头等前缀时只需一个小缓冲区。
+     * 返回长度之后的缓冲区内容可能被改写。
+     * @param src 压缩数据
+     * @param srcSize 压缩数据大小
+     * @param dst 输出缓冲区
+     * @param dstSize 输出缓冲区大小
+     * @return 实际写入的字节数
+     */
+    static size_t decodeInto(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+    /**
+     * @brief 解压开头被异或加密的数据（如GR文件），不修改源数据
+     *
+     * src的前keySize字节在读取时与密钥流异或，之后的部分直接读取，
+     * 因此src可以是只读的文件映射或PAK条目视图，不需要先复制出解密后的数据。
+     * @param src 压缩数据
+     * @param srcSize 压缩数据大小
+     * @param keystream 密钥流
+     * @param keySize 加密部分的字节数（超过srcSize的部分忽略）
+     * @param dst 输出缓冲区
+     * @param dstSize 输出缓冲区大小
+     * @return 实际写入的字节数
+     */
+    static size_t decodeInto(const uint8_t* src, size_t srcSize, const uint8_t* keystream, size_t keySize,
+                             uint8_t* dst, size_t dstSize);
+
+    /**
+     * @brief 计算解压后的大小
+     *
+     * 只扫描标记字节和匹配长度，不复制数据。
+     * @param src 压缩数据
+     * @param srcSize 压缩数据大小
+     * @return 解压后的字节数
+     */
+    static size_t getDecodedSize(const uint8_t* src, size_t srcSize);
+
+    /**
+     * @brief 计算开头被异或加密的数据解压后的大小，不修改源数据
+     * @param src 压缩数据
+     * @param srcSize 压缩数据大小
+     * @param keystream 密钥流
+     * @param keySize 加密部分的字节数
+     * @return 解压后的字节数
+     */
+    static size_t getDecodedSize(const uint8_t* src, size_t srcSize, const uint8_t* keystream, size_t keySize);
+
+    /**
+     * @brief 压缩文件
+     * @param inputFilename 输入文件名
+     * @param outputFilename 输出文件名
+     * @return 压缩后的文件大小
+     */
+    size_t encodeFile(const std::string& inputFilename, const std::string& outputFilename);
+
+    /**
+     * @brief 解压文件
+     * @param inputFilename 输入文件名
+     * @param outputFilename 输出文件名
+     * @return 解压后的文件大小
+     */
+    size_t decodeFile(const std::string& inputFilename, const std::string& outputFilename);
+
+private:
+    int maxChainDepth;  // 哈希链最大搜索深度
+    int threadCount;    // 压缩线程数
+    GrLevel level;      // 压缩级别
+    GrMatchFinder matchFinder;  // 最优解析的最长匹配查找方式
+    GrEncodeStats lastStats;  // 最近一次压缩的统计信息
+};
+
+/**
+ * @brief GR增量解压器
+ *
+ * 输入可以按任意大小分段提供，输出写入有限大小的缓冲区；
+ * 标记字节、组内项目序号、帧位置和未输出完的匹配都保存在对象中，跨调用保持。
+ */
+class EAGLS_COMPRESSION_API GrStreamDecoder {
+public:
+    /**
+     * @brief 构造函数
+     */
+    GrStreamDecoder();
+
+    /**
+     * @brief 重置为初始状态，开始解压新的数据
+     */
+    void reset();
+
+    /**
+     * @brief 解压一段输入
+     *
+     * 输出缓冲区写满或输入用完时返回，未消耗的输入需在下次调用时重新提供。
+     * 输入全部消耗后，若输出缓冲区被写满，应继续以空输入调用以取出剩余的匹配数据。
+     * @param src 输入数据
+     * @param srcSize 输入数据大小
+     * @param dst 输出缓冲区
+     * @param dstSize 输出缓冲区大小
+     * @param consumed 本次消耗的输入字节数
+     * @return 本次写出的字节数
+     */
+    size_t decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize, size_t& consumed);
+
+private:
+    uint8_t m_frame[GrLzss::FRAME_SIZE];  // 环形帧
+    size_t m_framePos;        // 帧写入位置
+    uint8_t m_flags;          // 当前组的标记字节
+    int m_itemIndex;          // 组内下一个项目的序号，8表示需要读取新的标记字节
+    uint8_t m_lo;             // 已读入的匹配项低字节
+    bool m_haveLo;            // 是否已读入匹配项低字节
+    size_t m_matchOffset;     // 未输出完的匹配的帧偏移
+    size_t m_matchRemaining;  // 未输出完的匹配剩余长度
+};
+
+} // namespace compression
+} // namespace eagls
@@ -8,6 +8,8 @@
 #ifdef _WIN32
     #ifdef EAGLS_COMPRESSION_EXPORTS
         #define EAGLS_COMPRESSION_API __declspec(dllexport)
+    #elif defined(EAGLS_COMPRESSION_STATIC)
+        #define EAGLS_COMPRESSION_API
     #else
         #define EAGLS_COMPRESSION_API __declspec(dllimport)
     #endif
@@ -28,8 +30,9 @@ public:
     /**
      * @brief 构造函数
      * @param preBufSizeBits 前向缓冲区占用的比特位
+     * @param maxChainDepth 每个位置最多检查的哈希链候选数（越大压缩率越高、速度越慢）
      */
-    explicit LZSS(int preBufSizeBits = 7);
+    explicit LZSS(int preBufSizeBits = 7, int maxChainDepth = 256);
     
     /**
      * @brief 压缩数据
@@ -67,6 +70,7 @@ private:
     int windowBufSizeBits;   // 滑动窗口占用的比特位
     int preBufSize;          // 前向缓冲区大小
     int windowBufSize;       // 滑动窗口大小
+    int maxChainDepth;       // 哈希链最大搜索深度
 };
 
 } // namespace compression
@@ -0,0 +1,311 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "core/encryption/xor_kernels.h"
+
+namespace eagls {
+namespace encryption {
+namespace cipher {
+
+/*
+ * EAGLS的三种加密都是"随机数生成器 + 密钥表 + 异或"：
+ *   GR  ：Lehmer生成器，密钥"EAGLS_SYSTEM"，从偏移0起连续处理，最多0x174b字节，种子为最后一个字节
+ *   DAT ：C运行时生成器，密钥"EAGLS_SYSTEM"，从偏移3600起每隔一个字节处理，种子为最后一个字节
+ *   索引：C运行时生成器，46字节密钥，从偏移0起连续处理，种子为尾部4字节
+ * 这里用一个模板统一实现，密钥长度、偏移、步长都是编译期常量，
+ * 取模变成常数除法，异或交给xor_kernels的向量实现。
+ * 种子从数据中取出的方式见grSeed、datSeed。
+ */
+
+inline constexpr char EAGLS_KEY[] = "EAGLS_SYSTEM";
+inline constexpr char INDEX_KEY[] = "1qaz2wsx3edc4rfv5tgb6yhn7ujm8ik,9ol.0p;/-@:^[]";
+
+constexpr size_t NO_LIMIT = SIZE_MAX;
+
+/**
+ * @brief 编译期计算密钥长度
+ */
+constexpr size_t keyLength(const char* key) {
+    size_t length = 0;
+    while (key[length] != '\0') {
+        ++length;
+    }
+    return length;
+}
+
+/**
+ * @brief C运行时（MSVC）随机数生成器：seed = seed * 214013 + 2531011
+ */
+struct CRuntimeRng {
+    static constexpr bool CAN_DISCARD = true;
+
+    uint32_t seed = 0;
+
+    constexpr void srand(uint32_t value) {
+        seed = value;
+    }
+
+    constexpr uint32_t rand() {
+        seed = seed * 214013u + 2531011u;
+        return (seed >> 16) & 0x7FFF;
+    }
+
+    /**
+     * @brief 跳过n个随机数，n步迭代仍是仿射变换，用倍增法O(log n)求出
+     */
+    constexpr void discard(uint64_t n) {
+        uint32_t mul = 1;
+        uint32_t add = 0;
+        uint32_t stepMul = 214013u;
+        uint32_t stepAdd = 2531011u;
+        while (n != 0) {
+            if (n & 1) {
+                mul = mul * stepMul;
+                add = add * stepMul + stepAdd;
+            }
+            stepAdd = stepAdd * stepMul + stepAdd;
+            stepMul = stepMul * stepMul;
+            n >>= 1;
+        }
+        seed = seed * mul + add;
+    }
+};
+
+/**
+ * @brief Lehmer（Park-Miller）随机数生成器，用Schrage方法避免溢出
+ */
+struct LehmerRng {
+    static constexpr bool CAN_DISCARD = false;
+
+    int32_t seed = 0;
+
+    constexpr void srand(uint32_t value) {
+        seed = static_cast<int32_t>(value ^ 123459876u);
+    }
+
+    uint32_t rand() {
+        seed = 48271 * (seed % 44488) - 3399 * (seed / 44488);
+        if (seed < 0) {
+            seed += 2147483647;
+        }
+        // 与原实现一致，经过double换算到0-255
+        return static_cast<uint32_t>(static_cast<int32_t>(seed * 4.656612875245797e-10 * 256));
+    }
+};
+
+/**
+ * @brief 取出GR的种子：最后一个字节的无符号值
+ * @param last 数据的最后一个字节
+ */
+constexpr uint32_t grSeed(uint8_t last) {
+    return last;
+}
+
+/**
+ * @brief 取出DAT的种子：最后一个字节按有符号char扩展
+ *
+ * 原版把这个字节作为char传给srand，0x80以上的值扩展成0xFFFFFF80等，
+ * 按无符号值传入时得到的密钥流与游戏不同。
+ * @param last 数据的最后一个字节
+ */
+constexpr uint32_t datSeed(uint8_t last) {
+    return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int8_t>(last)));
+}
+
+/**
+ * @brief 加密模板
+ * @tparam Rng 随机数生成器
+ * @tparam Key 密钥表
+ * @tparam Offset 加密区域在数据中的起始偏移
+ * @tparam Stride 相邻两个加密字节的间隔
+ * @tparam Limit 最多加密的字节数，NO_LIMIT表示不限
+ */
+template <class Rng, const char* Key, size_t Offset, size_t Stride, size_t Limit>
+class Cipher {
+public:
+    static constexpr size_t KEY_LENGTH = keyLength(Key);
+    static constexpr size_t OFFSET = Offset;
+    static constexpr size_t STRIDE = Stride;
+    static constexpr size_t LIMIT = Limit;
+    static constexpr bool CAN_SPLIT = Rng::CAN_DISCARD;  // 能否跳到任意位置分段生成
+
+    static_assert(KEY_LENGTH > 0, "key must not be empty");
+    static_assert(Stride > 0, "stride must be positive");
+
+    /**
+     * @brief 计算加密区域 [0, end) 中要处理的字节数
+     * @param end 加密区域的结束位置（不含）
+     * @return 密钥流字节数
+     */
+    static constexpr size_t countFor(size_t end) {
+        if (end <= Offset) {
+            return 0;
+        }
+        return std::min((end - Offset + Stride - 1) / Stride, Limit);
+    }
+
+    /**
+     * @brief 生成密钥流中 [first, first + count) 这一段
+     * @param seed 种子
+     * @param first 起始序号
+     * @param out 输出缓冲区
+     * @param count 字节数
+     */
+    static void keystream(uint32_t seed, size_t first, uint8_t* out, size_t count) {
+        Rng rng;
+        rng.srand(seed);
+        if constexpr (Rng::CAN_DISCARD) {
+            rng.discard(first);
+        } else {
+            for (size_t i = 0; i < first; ++i) {
+                rng.rand();
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<uint8_t>(Key[rng.rand() % KEY_LENGTH]);
+        }
+    }
+
+    /**
+     * @brief 原地加解密（两者相同）
+     * @param data 数据
+     * @param end 加密区域的结束位置（不含），通常为数据大小减去种子等尾部字节
+     * @param seed 种子
+     */
+    static void apply(uint8_t* data, size_t end, uint32_t seed) {
+        applyRange(data, 0, end, end, seed);
+    }
+
+    /**
+     * @brief 只加解密数据中的一段，用于分块读写时逐块处理
+     * @param data 指向数据中position处，原地修改
+     * @param position 这一段在数据中的位置
+     * @param size 这一段的字节数
+     * @param end 整个数据的加密区域结束位置（不含），与apply相同
+     * @param seed 种子
+     */
+    static void applyRange(uint8_t* data, size_t position, size_t size, size_t end, uint32_t seed) {
+        constexpr size_t BLOCK = 4096;
+        uint8_t block[BLOCK];
+
+        // 这一段对应的密钥流序号 [first, last)
+        const size_t first = countFor(position);
+        const size_t last = countFor(std::min(end, position + size));
+        if (first >= last) {
+            return;
+        }
+
+        Rng rng;
+        rng.srand(seed);
+        if constexpr (Rng::CAN_DISCARD) {
+            rng.discard(first);
+        } else {
+            for (size_t i = 0; i < first; ++i) {
+                rng.rand();
+            }
+        }
+        const size_t count = last - first;
+        uint8_t* base = data + (Offset + first * Stride - position);
+
+        // 按块生成密钥流再整块异或
+        for (size_t done = 0; done < count;) {
+            const size_t n = std::min(BLOCK, count - done);
+            for (size_t i = 0; i < n; ++i) {
+                block[i] = static_cast<uint8_t>(Key[rng.rand() % KEY_LENGTH]);
+            }
+            if constexpr (Stride == 1) {
+                xorKeystream(base + done, block, n);
+            } else if constexpr (Stride == 2) {
+                xorKeystreamStride2(base + 2 * done, block, n);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    base[(done + i) * Stride] ^= block[i];
+                }
+            }
+            done += n;
+        }
+    }
+};
+
+/**
+ * @brief 参数在运行时给出的加密，用于内置模板之外的密钥配置
+ *
+ * 算法与Cipher相同，只是取模和步长不再是编译期常量。
+ * @tparam Rng 随机数生成器
+ */
+template <class Rng>
+struct RuntimeCipher {
+    const char* key = nullptr;  // 密钥表
+    size_t keyLength = 0;       // 密钥长度
+    size_t offset = 0;          // 加密区域起始偏移
+    size_t stride = 1;          // 加密字节间隔
+    size_t limit = NO_LIMIT;    // 最多加密的字节数
+
+    size_t countFor(size_t end) const {
+        if (end <= offset) {
+            return 0;
+        }
+        return std::min((end - offset + stride - 1) / stride, limit);
+    }
+
+    void keystream(uint32_t seed, size_t first, uint8_t* out, size_t count) const {
+        Rng rng;
+        rng.srand(seed);
+        if constexpr (Rng::CAN_DISCARD) {
+            rng.discard(first);
+        } else {
+            for (size_t i = 0; i < first; ++i) {
+                rng.rand();
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<uint8_t>(key[rng.rand() % keyLength]);
+        }
+    }
+
+    void apply(uint8_t* data, size_t end, uint32_t seed) const {
+        constexpr size_t BLOCK = 4096;
+        uint8_t block[BLOCK];
+
+        if (keyLength == 0 || stride == 0) {
+            return;
+        }
+
+        Rng rng;
+        rng.srand(seed);
+        const size_t count = countFor(end);
+        uint8_t* base = data + offset;
+
+        for (size_t done = 0; done < count;) {
+            const size_t n = std::min(BLOCK, count - done);
+            for (size_t i = 0; i < n; ++i) {
+                block[i] = static_cast<uint8_t>(key[rng.rand() % keyLength]);
+            }
+            if (stride == 1) {
+                xorKeystream(base + done, block, n);
+            } else if (stride == 2) {
+                xorKeystreamStride2(base + 2 * done, block, n);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    base[(done + i) * stride] ^= block[i];
+                }
+            }
+            done += n;
+        }
+    }
+};
+
+// GR（CG）加密
+using GrCipher = Cipher<LehmerRng, EAGLS_KEY, 0, 1, 0x174b>;
+
+// DAT（脚本）加密
+using DatCipher = Cipher<CRuntimeRng, EAGLS_KEY, 3600, 2, NO_LIMIT>;
+
+// 索引加密
+using IndexCipher = Cipher<CRuntimeRng, INDEX_KEY, 0, 1, NO_LIMIT>;
+
+} // namespace cipher
+} // namespace encryption
+} // namespace eagls
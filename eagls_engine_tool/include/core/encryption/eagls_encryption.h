@@ -2,13 +2,18 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <cstdint>
+#include <cstddef>
 #include "lehmer.h"
+#include "key_profile.h"
 
 // DLL导出宏定义
 #ifdef _WIN32
     #ifdef EAGLS_ENCRYPTION_EXPORTS
         #define EAGLS_ENCRYPTION_API __declspec(dllexport)
+    #elif defined(EAGLS_ENCRYPTION_STATIC)
+        #define EAGLS_ENCRYPTION_API
     #else
         #define EAGLS_ENCRYPTION_API __declspec(dllimport)
     #endif
@@ -19,6 +24,70 @@
 namespace eagls {
 namespace encryption {
 
+/**
+ * @brief 按种子缓存的密钥流
+ *
+ * 三种加密的种子空间都很小：GR（Lehmer）与DAT取数据的最后一个字节，
+ * 索引的种子是尾部4字节，几乎总是同一个值。第一次用到某个种子时生成密钥流并缓存，
+ * 之后加解密只需与缓存表逐字节异或，不再每个字节调用rand()和取模。
+ * 缓存由所有线程共享，每种加密最多保留64MB，超出时淘汰最久未使用的种子；
+ * 需要更长的密钥流时生成新表替换，调用者已取得的旧表仍然有效。
+ */
+class EAGLS_ENCRYPTION_API KeystreamCache {
+public:
+    using Keystream = std::shared_ptr<const std::vector<uint8_t>>;
+
+    static constexpr size_t LEHMER_LIMIT = cipher::GrCipher::LIMIT;      // Lehmer加密覆盖的最大字节数
+    static constexpr size_t DAT_TEXT_OFFSET = cipher::DatCipher::OFFSET; // DAT加密区域的起始偏移
+
+    /**
+     * @brief 获取Lehmer（GR）密钥流
+     * @param seed 种子（数据的最后一个字节）
+     * @return 长度为LEHMER_LIMIT的密钥流
+     */
+    static Keystream getLehmer(uint8_t seed);
+
+    /**
+     * @brief 获取EAGLS（DAT）密钥流
+     *
+     * 第k个字节对应数据中 DAT_TEXT_OFFSET + 2k 处的字节。
+     * @param seed 种子（数据的最后一个字节）
+     * @param length 至少需要的字节数
+     * @return 长度不小于length的密钥流
+     */
+    static Keystream getEagls(uint8_t seed, size_t length);
+
+    /**
+     * @brief 获取索引密钥流
+     * @param seed 种子（索引的尾部4字节）
+     * @param length 至少需要的字节数
+     * @return 长度不小于length的密钥流
+     */
+    static Keystream getIndex(uint32_t seed, size_t length);
+
+    /**
+     * @brief 不经过缓存，直接生成EAGLS（DAT）密钥流的任意一段
+     *
+     * 生成器可以跳到任意位置，只需要一个段时不必生成前面的全部密钥流；较长时分给多个线程生成。
+     * @param seed 种子
+     * @param first 起始序号（第k个字节对应数据中 DAT_TEXT_OFFSET + 2k 处）
+     * @param out 输出缓冲区
+     * @param count 字节数
+     */
+    static void generateEagls(uint8_t seed, size_t first, uint8_t* out, size_t count);
+
+    /**
+     * @brief 不经过缓存，直接生成索引密钥流的任意一段
+     *
+     * 可用于只加解密一条索引记录。
+     * @param seed 种子
+     * @param first 起始偏移（在索引中的字节偏移）
+     * @param out 输出缓冲区
+     * @param count 字节数
+     */
+    static void generateIndex(uint32_t seed, size_t first, uint8_t* out, size_t count);
+};
+
 /**
  * @brief EAGLS加密实现
  *
@@ -27,10 +96,16 @@ namespace encryption {
 class EAGLS_ENCRYPTION_API EaglsEncryption {
 public:
     /**
-     * @brief 构造函数
+     * @brief 构造函数，使用默认密钥配置
      */
     EaglsEncryption();
 
+    /**
+     * @brief 构造函数
+     * @param profile 密钥配置（使用其中的EAGLS密钥和DAT文本偏移）
+     */
+    explicit EaglsEncryption(const KeyProfile& profile);
+
     /**
      * @brief 加密数据
      * @param data 要加密的数据
@@ -45,6 +120,34 @@ public:
      */
     std::vector<uint8_t> decrypt(const std::vector<uint8_t>& data);
 
+    /**
+     * @brief 原地加密数据
+     *
+     * 不复制数据，适合调用者不再需要原数据的场合。
+     * @param data 要加密的数据
+     * @param size 数据大小
+     */
+    void encryptInPlace(uint8_t* data, size_t size);
+
+    /**
+     * @brief 原地解密数据
+     * @param data 要解密的数据
+     * @param size 数据大小
+     */
+    void decryptInPlace(uint8_t* data, size_t size);
+
+    /**
+     * @brief 只加解密文件中的一段（如单个段）
+     *
+     * 加密和解密相同。密钥流从这一段对应的位置直接生成，不处理前面的数据。
+     * @param data 指向文件偏移offset处的数据，原地修改
+     * @param offset 这一段在文件中的偏移
+     * @param size 这一段的字节数
+     * @param fileSize 整个文件的大小
+     * @param seed 种子（整个文件的最后一个字节）
+     */
+    void decryptRange(uint8_t* data, size_t offset, size_t size, size_t fileSize, uint8_t seed);
+
     /**
      * @brief 加密文件
      * @param inputFilename 输入文件名
@@ -62,16 +165,8 @@ public:
     bool decryptFile(const std::string& inputFilename, const std::string& outputFilename);
 
 private:
-    CRuntimeRandomGenerator m_rng;  // 随机数生成器
-
-#ifdef _MSC_VER
-    #pragma warning(push)
-    #pragma warning(disable: 4251)  // 禁用C4251警告
-#endif
-    std::string m_key;              // 加密密钥
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif
+    KeyProfile m_profile;   // 密钥配置
+    bool m_builtin;         // 是否与内置实现一致，可使用密钥流缓存
 };
 
 /**
@@ -82,10 +177,16 @@ private:
 class EAGLS_ENCRYPTION_API LehmerEncryption {
 public:
     /**
-     * @brief 构造函数
+     * @brief 构造函数，使用默认密钥配置
      */
     LehmerEncryption();
 
+    /**
+     * @brief 构造函数
+     * @param profile 密钥配置（使用其中的EAGLS密钥和Lehmer加密长度）
+     */
+    explicit LehmerEncryption(const KeyProfile& profile);
+
     /**
      * @brief 加密数据
      * @param data 要加密的数据
@@ -100,17 +201,92 @@ public:
      */
     std::vector<uint8_t> decrypt(const std::vector<uint8_t>& data);
 
+    /**
+     * @brief 原地加密数据
+     *
+     * 不复制数据，只修改开头最多lehmerLimit（默认0x174b）字节。
+     * @param data 要加密的数据
+     * @param size 数据大小
+     */
+    void encryptInPlace(uint8_t* data, size_t size);
+
+    /**
+     * @brief 原地解密数据
+     * @param data 要解密的数据
+     * @param size 数据大小
+     */
+    void decryptInPlace(uint8_t* data, size_t size);
+
+    /**
+     * @brief 只加解密文件中的一段，用于分块读写
+     *
+     * 加密和解密相同。只有开头lehmerLimit字节内的部分会被修改。
+     * @param data 指向文件偏移offset处的数据，原地修改
+     * @param offset 这一段在文件中的偏移
+     * @param size 这一段的字节数
+     * @param fileSize 整个文件的大小
+     * @param seed 种子（整个文件的最后一个字节）
+     */
+    void decryptRange(uint8_t* data, size_t offset, size_t size, size_t fileSize, uint8_t seed);
+
+    /**
+     * @brief 获取密钥流，用于读取数据时边异或边处理而不修改数据
+     *
+     * 数据的第i个字节（i < min(size - 1, 密钥流长度)）与密钥流的第i个字节异或。
+     * @param seed 种子（数据的最后一个字节）
+     * @return 长度为lehmerLimit的密钥流
+     */
+    KeystreamCache::Keystream getKeystream(uint8_t seed) const;
+
 private:
-    LehmerRandomGenerator m_rng;  // 随机数生成器
+    KeyProfile m_profile;   // 密钥配置
+    bool m_builtin;         // 是否与内置实现一致，可使用密钥流缓存
+};
 
-#ifdef _MSC_VER
-    #pragma warning(push)
-    #pragma warning(disable: 4251)  // 禁用C4251警告
-#endif
-    std::string m_key;            // 加密密钥
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif
+/**
+ * @brief 索引加密实现
+ *
+ * 索引的尾部4字节是种子，其余部分与密钥流逐字节异或。
+ */
+class EAGLS_ENCRYPTION_API IndexEncryption {
+public:
+    /**
+     * @brief 构造函数，使用默认密钥配置
+     */
+    IndexEncryption();
+
+    /**
+     * @brief 构造函数
+     * @param profile 密钥配置（使用其中的索引密钥）
+     */
+    explicit IndexEncryption(const KeyProfile& profile);
+
+    /**
+     * @brief 原地加密整个索引
+     * @param data 索引数据，尾部4字节为种子
+     * @param size 索引大小
+     */
+    void encryptInPlace(uint8_t* data, size_t size);
+
+    /**
+     * @brief 原地解密整个索引
+     * @param data 索引数据，尾部4字节为种子
+     * @param size 索引大小
+     */
+    void decryptInPlace(uint8_t* data, size_t size);
+
+    /**
+     * @brief 只加解密索引中的一段（如开头几条记录或单条记录）
+     * @param data 指向索引偏移offset处的数据，原地修改
+     * @param offset 这一段在索引中的偏移
+     * @param size 这一段的字节数
+     * @param seed 种子（索引的尾部4字节）
+     */
+    void decryptRange(uint8_t* data, size_t offset, size_t size, uint32_t seed);
+
+private:
+    KeyProfile m_profile;   // 密钥配置
+    bool m_builtin;         // 是否与内置实现一致，可使用密钥流缓存
 };
 
 } // namespace encryption
@@ -0,0 +1,102 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_ENCRYPTION_EXPORTS
+        #define EAGLS_ENCRYPTION_API __declspec(dllexport)
+    #elif defined(EAGLS_ENCRYPTION_STATIC)
+        #define EAGLS_ENCRYPTION_API
+    #else
+        #define EAGLS_ENCRYPTION_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_ENCRYPTION_API
+#endif
+
+namespace eagls {
+namespace encryption {
+
+/**
+ * @brief 密钥配置
+ *
+ * 不同的EAGLS游戏在索引密钥、DAT文本偏移、Lehmer加密长度和DAT段表布局上可能不同，
+ * 这些参数集中在这里，PAK、DAT和加密模块都从配置中读取。
+ */
+struct EAGLS_ENCRYPTION_API KeyProfile {
+    std::string name;              // 配置名称
+    std::string indexKey;          // 索引密钥
+    std::string eaglsKey;          // GR与DAT的密钥
+    size_t indexSize;              // 索引文件大小（含尾部4字节种子）
+    size_t indexEntrySize;         // 索引条目大小
+    size_t indexNameSize;          // 索引条目中文件名的大小
+    uint64_t pakDataOffset;        // 索引中记录的偏移与PAK文件中实际位置之差
+    size_t lehmerLimit;            // GR加密覆盖的最大字节数
+    size_t datTextOffset;          // DAT文本偏移（即段表大小，也是加密区域起始偏移）
+    size_t datSectionEntrySize;    // DAT段表条目大小
+    size_t datSectionNameSize;     // DAT段名大小
+
+    /**
+     * @brief 检查参数是否自洽
+     * @return 是否有效
+     */
+    bool isValid() const;
+
+    /**
+     * @brief GR加密是否与内置的编译期实现一致（可以使用密钥流缓存）
+     */
+    bool usesBuiltinGrCipher() const;
+
+    /**
+     * @brief DAT加密是否与内置的编译期实现一致
+     */
+    bool usesBuiltinDatCipher() const;
+
+    /**
+     * @brief 索引加密是否与内置的编译期实现一致
+     */
+    bool usesBuiltinIndexCipher() const;
+};
+
+/**
+ * @brief 密钥配置表
+ *
+ * 内置当前已知的配置，其他游戏的配置可在运行时注册。
+ * 所有函数都是线程安全的，返回的是配置的副本。
+ */
+class EAGLS_ENCRYPTION_API KeyProfileRegistry {
+public:
+    /**
+     * @brief 获取默认配置
+     * @return 默认配置
+     */
+    static const KeyProfile& getDefault();
+
+    /**
+     * @brief 获取所有配置，默认配置在最前
+     * @return 配置列表
+     */
+    static std::vector<KeyProfile> getProfiles();
+
+    /**
+     * @brief 按名称查找配置
+     * @param name 配置名称
+     * @param profile 输出配置
+     * @return 是否找到
+     */
+    static bool findProfile(const std::string& name, KeyProfile& profile);
+
+    /**
+     * @brief 注册配置
+     * @param profile 配置
+     * @return 是否成功（名称重复或参数无效时失败）
+     */
+    static bool registerProfile(const KeyProfile& profile);
+};
+
+} // namespace encryption
+} // namespace eagls
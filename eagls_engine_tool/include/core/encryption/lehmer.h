@@ -1,11 +1,14 @@
 ﻿#pragma once
 
 #include <cstdint>
+#include "core/encryption/eagls_cipher.h"
 
 // DLL导出宏定义
 #ifdef _WIN32
     #ifdef EAGLS_ENCRYPTION_EXPORTS
         #define EAGLS_ENCRYPTION_API __declspec(dllexport)
+    #elif defined(EAGLS_ENCRYPTION_STATIC)
+        #define EAGLS_ENCRYPTION_API
     #else
         #define EAGLS_ENCRYPTION_API __declspec(dllimport)
     #endif
@@ -19,7 +22,7 @@ namespace encryption {
 /**
  * @brief Lehmer随机数生成器
  * 
- * 基于Python脚本中的LehmerRandomGenerator重写的C++版本
+ * 基于Python脚本中的LehmerRandomGenerator重写的C++版本，算法见cipher::LehmerRng
  */
 class EAGLS_ENCRYPTION_API LehmerRandomGenerator {
 public:
@@ -41,13 +44,13 @@ public:
     uint32_t rand();
 
 private:
-    uint32_t m_seed;  // 随机数种子
+    cipher::LehmerRng m_rng;  // 随机数生成器
 };
 
 /**
  * @brief C运行时随机数生成器
  * 
- * 基于Python脚本中的CRuntimeRandomGenerator重写的C++版本
+ * 基于Python脚本中的CRuntimeRandomGenerator重写的C++版本，算法见cipher::CRuntimeRng
  */
 class EAGLS_ENCRYPTION_API CRuntimeRandomGenerator {
 public:
@@ -68,8 +71,24 @@ public:
      */
     uint32_t rand();
 
+    /**
+     * @brief 跳过n个随机数
+     *
+     * 线性同余的n步迭代仍是仿射变换，用倍增法在O(log n)内求出，
+     * 可以直接跳到密钥流的任意位置，或把一段密钥流分给多个线程生成。
+     * @param n 跳过的个数
+     */
+    void discard(uint64_t n);
+
+    /**
+     * @brief 获取从当前状态起第n个随机数（从0开始），不改变当前状态
+     * @param n 序号
+     * @return 该位置的随机数
+     */
+    uint32_t at(uint64_t n) const;
+
 private:
-    uint32_t m_seed;  // 随机数种子
+    cipher::CRuntimeRng m_rng;  // 随机数生成器
 };
 
 } // namespace encryption
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_ENCRYPTION_EXPORTS
+        #define EAGLS_ENCRYPTION_API __declspec(dllexport)
+    #elif defined(EAGLS_ENCRYPTION_STATIC)
+        #define EAGLS_ENCRYPTION_API
+    #else
+        #define EAGLS_ENCRYPTION_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_ENCRYPTION_API
+#endif
+
+namespace eagls {
+namespace encryption {
+
+/**
+ * @brief 将数据与密钥流逐字节异或（GR与索引的加解密）
+ *
+ * 按运行时CPU支持的指令集选择实现（AVX2 > SSE2 > 标量）。
+ * @param data 要处理的数据，原地修改
+ * @param key 密钥流，长度不小于size
+ * @param size 字节数
+ */
+EAGLS_ENCRYPTION_API void xorKeystream(uint8_t* data, const uint8_t* key, size_t size);
+
+/**
+ * @brief 将数据中每隔一个字节与密钥流异或（DAT的加解密）
+ *
+ * 处理 data[0], data[2], ..., data[2 * (keySize - 1)]，奇数位置不变。
+ * 向量实现在寄存器内把密钥流与0交错展开，缓存中的密钥流仍保持紧凑。
+ * @param data 要处理的数据，原地修改，至少 2 * keySize - 1 字节
+ * @param key 密钥流
+ * @param keySize 密钥流字节数（即要处理的字节数）
+ */
+EAGLS_ENCRYPTION_API void xorKeystreamStride2(uint8_t* data, const uint8_t* key, size_t keySize);
+
+/**
+ * @brief 获取当前使用的异或实现名称
+ * @return "avx2"、"sse2"或"scalar"
+ */
+EAGLS_ENCRYPTION_API const char* getXorKernelName();
+
+} // namespace encryption
+} // namespace eagls
@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <cstdint>
+#include "core/encryption/key_profile.h"
 
 // DLL导出宏定义
 #ifdef _WIN32
@@ -43,6 +44,18 @@ public:
      */
     ~DatFile();
     
+    /**
+     * @brief 设置密钥配置（加密参数与段表布局），之后打开或创建的DAT文件都使用该配置
+     * @param profile 密钥配置
+     */
+    void setProfile(const encryption::KeyProfile& profile);
+    
+    /**
+     * @brief 获取当前使用的密钥配置
+     * @return 密钥配置
+     */
+    const encryption::KeyProfile& getProfile() const;
+    
     /**
      * @brief 打开DAT文件
      * @param filename DAT文件名
@@ -110,6 +123,7 @@ private:
     std::vector<uint8_t> m_data;                  // 文件数据
     std::map<std::string, DatEntry> m_sections;   // 段映射
     bool m_isOpen;                                // 是否已打开
+    encryption::KeyProfile m_profile;             // 密钥配置
     
     /**
      * @brief 解析段表
@@ -38,6 +38,13 @@ public:
      */
     static bool writeFile(const std::string& filename, const std::vector<uint8_t>& data);
     
+    /**
+     * @brief 把文件已写入的内容刷到磁盘（POSIX为fsync，Windows为FlushFileBuffers）
+     * @param filename 文件名；POSIX上也可以是目录，Windows上目录直接返回true
+     * @return 是否成功
+     */
+    static bool syncFile(const std::string& filename);
+    
     /**
      * @brief 获取文件大小
      * @param filename 文件名
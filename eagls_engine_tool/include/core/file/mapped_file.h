@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_FILE_EXPORTS
+        #define EAGLS_FILE_API __declspec(dllexport)
+    #else
+        #define EAGLS_FILE_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_FILE_API
+#endif
+
+namespace eagls {
+namespace file {
+
+/**
+ * @brief 只读文件，优先内存映射
+ *
+ * 打开时尝试把整个文件映射到内存，失败时（如32位进程中的大文件）退回到按偏移读取
+ * （POSIX的pread，Windows的带偏移ReadFile）。两种方式都不使用共享的文件位置，
+ * 打开之后可被多个线程同时读取。
+ */
+class EAGLS_FILE_API MappedFile {
+public:
+    /**
+     * @brief 构造函数
+     */
+    MappedFile();
+
+    /**
+     * @brief 析构函数
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief 打开文件
+     * @param filename 文件名
+     * @param useMapping 是否尝试内存映射，false时总是按偏移读取
+     * @return 是否成功
+     */
+    bool open(const std::string& filename, bool useMapping = true);
+
+    /**
+     * @brief 关闭文件，之前取得的映射指针全部失效
+     */
+    void close();
+
+    /**
+     * @brief 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 是否已映射到内存
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief 获取文件大小
+     * @return 文件大小
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief 获取映射的内存
+     * @return 映射的首地址，未映射时为nullptr
+     */
+    const uint8_t* data() const;
+
+    /**
+     * @brief 读取一段数据（线程安全）
+     * @param offset 文件偏移
+     * @param buffer 输出缓冲区
+     * @param size 字节数
+     * @return 是否完整读取
+     */
+    bool read(uint64_t offset, void* buffer, size_t size) const;
+
+private:
+#ifdef _WIN32
+    void* m_handle;         // 文件句柄
+    void* m_mapping;        // 映射对象句柄
+#else
+    int m_fd;               // 文件描述符
+#endif
+    const uint8_t* m_data;  // 映射的内存
+    uint64_t m_size;        // 文件大小
+    bool m_isOpen;          // 是否已打开
+};
+
+} // namespace file
+} // namespace eagls
@@ -0,0 +1,207 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_FILE_EXPORTS
+        #define EAGLS_FILE_API __declspec(dllexport)
+    #else
+        #define EAGLS_FILE_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_FILE_API
+#endif
+
+namespace eagls {
+namespace file {
+
+/**
+ * @brief PAK文件条目
+ */
+struct EAGLS_FILE_API PakEntry {
+    std::string name;    // 文件名
+    uint64_t offset;     // 文件偏移
+    uint32_t size;       // 文件大小
+    uint32_t flags;      // 文件标志
+};
+
+/**
+ * @brief PAK条目表
+ *
+ * 按列连续存储：文件名是与索引中相同的定长字段（不足部分补0），偏移、大小、标志各占一个数组，
+ * 条目按加入的顺序编号（即索引中的记录顺序）。查找用开放寻址哈希表，可选择不区分大小写；
+ * 另外维护按偏移排序的条目序号，用于顺序读取。
+ */
+class EAGLS_FILE_API PakEntryTable {
+public:
+    static constexpr uint32_t NPOS = 0xFFFFFFFFu;   // 未找到
+
+    /**
+     * @brief 构造函数
+     * @param nameSize 文件名字段大小
+     * @param caseInsensitive 查找时是否不区分大小写
+     */
+    explicit PakEntryTable(size_t nameSize = 0x18, bool caseInsensitive = false);
+
+    /**
+     * @brief 清空并重新设置参数
+     * @param nameSize 文件名字段大小
+     * @param caseInsensitive 查找时是否不区分大小写
+     */
+    void reset(size_t nameSize, bool caseInsensitive);
+
+    /**
+     * @brief 清空所有条目
+     */
+    void clear();
+
+    /**
+     * @brief 预留空间
+     * @param count 条目数
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief 获取条目数
+     */
+    size_t size() const;
+
+    /**
+     * @brief 是否为空
+     */
+    bool empty() const;
+
+    /**
+     * @brief 获取文件名字段大小
+     */
+    size_t getNameSize() const;
+
+    /**
+     * @brief 查找时是否不区分大小写
+     */
+    bool isCaseInsensitive() const;
+
+    /**
+     * @brief 文件名能否作为条目名：非空、不含0、不超过字段大小（不检查是否已存在）
+     * @param name 文件名
+     */
+    bool isValidName(const std::string& name) const;
+
+    /**
+     * @brief 添加条目
+     * @param name 文件名
+     * @param offset 偏移（索引中记录的值）
+     * @param size 大小
+     * @param flags 标志
+     * @return 条目序号，文件名为空、超过字段大小或已存在时返回NPOS
+     */
+    uint32_t add(const std::string& name, uint64_t offset, uint32_t size, uint32_t flags);
+
+    /**
+     * @brief 添加条目（文件名不必以0结尾，如索引中的定长字段）
+     * @param name 文件名
+     * @param length 文件名长度
+     * @param offset 偏移（索引中记录的值）
+     * @param size 大小
+     * @param flags 标志
+     * @return 条目序号，文件名为空、超过字段大小或已存在时返回NPOS
+     */
+    uint32_t add(const char* name, size_t length, uint64_t offset, uint32_t size, uint32_t flags);
+
+    /**
+     * @brief 查找条目
+     * @param name 文件名
+     * @return 条目序号，未找到时返回NPOS
+     */
+    uint32_t find(const std::string& name) const;
+
+    /**
+     * @brief 获取文件名
+     * @param index 条目序号
+     * @return 文件名
+     */
+    std::string getName(uint32_t index) const;
+
+    /**
+     * @brief 获取定长的文件名字段（不一定以0结尾）
+     * @param index 条目序号
+     * @return 字段首地址，长度为getNameSize()
+     */
+    const char* getNameField(uint32_t index) const;
+
+    uint64_t getOffset(uint32_t index) const;   // 获取偏移
+    uint32_t getSize(uint32_t index) const;     // 获取大小
+    uint32_t getFlags(uint32_t index) const;    // 获取标志
+
+    /**
+     * @brief 获取条目
+     * @param index 条目序号
+     * @return 条目
+     */
+    PakEntry getEntry(uint32_t index) const;
+
+    /**
+     * @brief 修改条目的位置，之后需要重新调用sortByOffset
+     * @param index 条目序号
+     * @param offset 偏移
+     * @param size 大小
+     */
+    void setLocation(uint32_t index, uint64_t offset, uint32_t size);
+
+    /**
+     * @brief 按偏移重新排序，更新getOffsetOrder的结果
+     */
+    void sortByOffset();
+
+    /**
+     * @brief 获取按偏移排序的条目序号
+     *
+     * 在添加或修改条目后调用sortByOffset才会更新。
+     * @return 条目序号列表
+     */
+    const std::vector<uint32_t>& getOffsetOrder() const;
+
+    /**
+     * @brief 获取按文件名排序的条目序号（每次调用时计算）
+     * @return 条目序号列表
+     */
+    std::vector<uint32_t> getNameOrder() const;
+
+private:
+    size_t m_nameSize;                  // 文件名字段大小
+    bool m_caseInsensitive;             // 是否不区分大小写
+    std::vector<char> m_names;          // 文件名字段，每个m_nameSize字节
+    std::vector<uint64_t> m_offsets;    // 偏移
+    std::vector<uint32_t> m_sizes;      // 大小
+    std::vector<uint32_t> m_flags;      // 标志
+    std::vector<uint32_t> m_hashes;     // 文件名哈希值
+    std::vector<uint32_t> m_slots;      // 哈希表，保存条目序号加1，0表示空
+    std::vector<uint32_t> m_byOffset;   // 按偏移排序的条目序号
+
+    /**
+     * @brief 计算文件名哈希值
+     */
+    uint32_t hashName(const char* name, size_t length) const;
+
+    /**
+     * @brief 按哈希值查找文件名
+     */
+    uint32_t findName(const char* name, size_t length, uint32_t hash) const;
+
+    /**
+     * @brief 比较条目的文件名
+     */
+    bool nameEquals(uint32_t index, const char* name, size_t length) const;
+
+    /**
+     * @brief 扩大哈希表并重新插入所有条目
+     */
+    void rehash(size_t slotCount);
+};
+
+} // namespace file
+} // namespace eagls
@@ -2,8 +2,11 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <memory>
 #include <cstdint>
+#include "core/encryption/key_profile.h"
+#include "core/file/mapped_file.h"
+#include "core/file/pak_entry_table.h"
 
 // DLL导出宏定义
 #ifdef _WIN32
@@ -20,17 +23,84 @@ namespace eagls {
 namespace file {
 
 /**
- * @brief PAK文件条目
+ * @brief PAK条目数据的只读视图
+ *
+ * PAK文件映射到内存时直接指向映射的内存，不复制数据；按偏移读取时持有一份读入的数据。
+ * 视图持有文件的引用，PakFile关闭或重新打开后仍然有效，可以在线程间自由复制。
+ * 数据是PAK中存储的原样（未解密）。
  */
-struct EAGLS_FILE_API PakEntry {
+class EAGLS_FILE_API PakEntryView {
+public:
+    /**
+     * @brief 构造空视图
+     */
+    PakEntryView();
+    
+    /**
+     * @brief 获取数据
+     * @return 数据首地址
+     */
+    const uint8_t* data() const;
+    
+    /**
+     * @brief 获取数据大小
+     * @return 字节数
+     */
+    size_t size() const;
+
+private:
+    friend class PakFile;
+    
+    std::shared_ptr<const MappedFile> m_file;               // 映射的文件
+    std::shared_ptr<const std::vector<uint8_t>> m_buffer;   // 未映射时读入的数据
+    const uint8_t* m_data;                                  // 数据首地址
+    size_t m_size;                                          // 数据大小
+};
+
+/**
+ * @brief 批量提取时单个文件的结果
+ */
+struct EAGLS_FILE_API PakExtractResult {
     std::string name;    // 文件名
-    uint64_t offset;     // 文件偏移
-    uint32_t size;       // 文件大小
-    uint32_t flags;      // 文件标志
+    bool success;        // 是否成功
+    std::string error;   // 失败原因
+};
+
+/**
+ * @brief 替换时单个文件的结果
+ */
+struct EAGLS_FILE_API PakPatchResult {
+    std::string name;       // 文件名
+    bool success;           // 是否成功
+    bool inPlace;           // 是否覆盖在原位置
+    uint64_t freedBytes;    // 原位置空出的字节数
+};
+
+/**
+ * @brief 压缩PAK时条目的排列顺序
+ */
+enum class PakCompactOrder {
+    Offset,     // 保持原来的偏移顺序
+    Name,       // 按文件名排序
+    Index       // 按索引中的记录顺序
+};
+
+/**
+ * @brief 压缩PAK的结果
+ */
+struct EAGLS_FILE_API PakCompactResult {
+    uint32_t entryCount;        // 条目数
+    uint64_t originalSize;      // 原PAK大小
+    uint64_t compactedSize;     // 压缩后的PAK大小
+    uint64_t reclaimedBytes;    // 回收的字节数
+    uint64_t kernelBytes;       // 在内核中复制的字节数
 };
 
 /**
  * @brief PAK文件处理类
+ *
+ * 打开后PAK文件只打开一次并尽量映射到内存，getEntryView、readEntry和extractFile
+ * 不再为每个条目重新打开文件，可被多个线程同时调用。
  */
 class EAGLS_FILE_API PakFile {
 public:
@@ -44,24 +114,72 @@ public:
      */
     ~PakFile();
     
+    /**
+     * @brief 设置密钥配置，之后打开或创建的PAK文件都使用该配置
+     * @param profile 密钥配置
+     */
+    void setProfile(const encryption::KeyProfile& profile);
+    
+    /**
+     * @brief 获取当前使用的密钥配置
+     * @return 密钥配置
+     */
+    const encryption::KeyProfile& getProfile() const;
+    
     /**
      * @brief 打开PAK文件
      * @param pakFilename PAK文件名
+     * @param useMapping 是否把PAK文件映射到内存，false时按偏移读取
      * @return 是否成功
      */
-    bool open(const std::string& pakFilename);
+    bool open(const std::string& pakFilename, bool useMapping = true);
+    
+    /**
+     * @brief PAK文件是否已映射到内存
+     * @return 是否已映射
+     */
+    bool isMapped() const;
     
     /**
      * @brief 关闭PAK文件
      */
     void close();
     
+    /**
+     * @brief 设置查找文件名时是否不区分大小写，之后打开或创建的PAK文件生效
+     * @param caseInsensitive 是否不区分大小写
+     */
+    void setCaseInsensitiveLookup(bool caseInsensitive);
+    
     /**
      * @brief 获取文件列表
-     * @return 文件列表
+     * @return 文件列表（索引中的顺序）
      */
     std::vector<std::string> getFileList() const;
     
+    /**
+     * @brief 获取条目表
+     * @return 条目表
+     */
+    const PakEntryTable& getEntries() const;
+    
+    /**
+     * @brief 获取条目数据的只读视图（未解密）
+     * @param filename 文件名
+     * @param view 输出视图
+     * @return 是否成功
+     */
+    bool getEntryView(const std::string& filename, PakEntryView& view) const;
+    
+    /**
+     * @brief 读取条目数据
+     * @param filename 文件名
+     * @param data 输出数据
+     * @param decrypt 是否解密
+     * @return 是否成功
+     */
+    bool readEntry(const std::string& filename, std::vector<uint8_t>& data, bool decrypt = true) const;
+    
     /**
      * @brief 提取文件
      * @param filename 要提取的文件名
@@ -71,13 +189,30 @@ public:
      */
     bool extractFile(const std::string& filename, const std::string& outputPath, bool decrypt = true);
     
+    /**
+     * @brief 设置批量提取的线程数
+     * @param threadCount 线程数，0表示使用全部硬件线程
+     */
+    void setThreadCount(int threadCount);
+    
+    /**
+     * @brief 设置批量提取时已读出但尚未写完的数据上限
+     * @param maxPendingBytes 字节数，单个更大的文件仍会被提取
+     */
+    void setMaxPendingBytes(size_t maxPendingBytes);
+    
     /**
      * @brief 提取所有文件
+     *
+     * 调用线程按偏移递增的顺序读取条目，解密和写入在工作线程中进行；
+     * 已读出未写完的数据超过上限时读取等待。
      * @param outputPath 输出路径
      * @param decrypt 是否解密
-     * @return 是否成功
+     * @param report 输出每个文件的结果，按索引中的顺序排列，可为nullptr
+     * @return 是否全部成功
      */
-    bool extractAllFiles(const std::string& outputPath, bool decrypt = true);
+    bool extractAllFiles(const std::string& outputPath, bool decrypt = true,
+                         std::vector<PakExtractResult>* report = nullptr);
     
     /**
      * @brief 创建PAK文件
@@ -96,11 +231,87 @@ public:
      * @return 是否成功
      */
     bool addFile(const std::string& pakFilename, const std::string& filename, bool encrypt = true);
+    
+    /**
+     * @brief 替换PAK文件中已有的条目，不重建整个PAK
+     *
+     * 新数据不大于原条目时覆盖原位置，否则追加到PAK末尾，原位置成为空闲空间。
+     * 索引只重写改动的记录。
+     * @param pakFilename PAK文件名
+     * @param files 替换用的文件列表，按文件名对应条目
+     * @param encrypt 是否加密
+     * @param report 输出每个文件的结果，按files的顺序排列，可为nullptr
+     * @return 是否全部成功
+     */
+    bool patchFiles(const std::string& pakFilename, const std::vector<std::string>& files, bool encrypt = true,
+                    std::vector<PakPatchResult>* report = nullptr);
+    
+    /**
+     * @brief 按指定顺序连续重写PAK，去掉替换和删除后留下的空闲空间
+     *
+     * 条目数据原样复制（Linux上用copy_file_range或sendfile在内核中复制，否则用大块读写），
+     * 不解密也不重新加密，之后写入新的索引。输出到原PAK时先写临时文件，再依次重命名PAK和索引。
+     * 完成后打开输出的PAK。
+     * @param pakFilename PAK文件名
+     * @param outputFilename 输出的PAK文件名，为空时替换原PAK
+     * @param order 条目顺序
+     * @param result 输出压缩结果，可为nullptr
+     * @return 是否成功
+     */
+    bool compact(const std::string& pakFilename, const std::string& outputFilename = "",
+                 PakCompactOrder order = PakCompactOrder::Offset, PakCompactResult* result = nullptr);
+    
+    /**
+     * @brief 构造索引文件名（与PAK同名，扩展名为.idx）
+     * @param pakFilename PAK文件名
+     * @return 索引文件名
+     */
+    static std::string getIndexFilename(const std::string& pakFilename);
 
 private:
+    friend class PakTransaction;
+    
     std::string m_pakFilename;                  // PAK文件名
-    std::map<std::string, PakEntry> m_entries;  // 文件条目
+    PakEntryTable m_entries;                    // 文件条目
     bool m_isOpen;                              // 是否已打开
+    bool m_caseInsensitive;                     // 查找时是否不区分大小写
+    int m_threadCount;                          // 批量提取线程数
+    size_t m_maxPendingBytes;                   // 批量提取时未写完的数据上限
+    encryption::KeyProfile m_profile;           // 密钥配置
+    std::shared_ptr<MappedFile> m_data;         // 打开的PAK文件数据
+    std::vector<uint32_t> m_records;            // 每个条目在索引中的记录序号
+    uint32_t m_indexSeed;                       // 索引尾部的种子
+    
+    /**
+     * @brief 打开PAK文件数据
+     * @param useMapping 是否映射到内存
+     * @return 是否成功
+     */
+    bool openData(bool useMapping);
+    
+    /**
+     * @brief 按条目序号获取数据视图
+     * @param index 条目序号
+     * @param view 输出视图
+     * @return 是否成功
+     */
+    bool getEntryViewAt(uint32_t index, PakEntryView& view) const;
+    
+    /**
+     * @brief 根据文件类型解密条目数据
+     * @param filename 文件名
+     * @param data 数据
+     */
+    void decryptEntry(const std::string& filename, std::vector<uint8_t>& data) const;
+    
+    /**
+     * @brief 把条目数据写到输出路径下
+     * @param filename 文件名
+     * @param outputPath 输出路径
+     * @param data 数据
+     * @return 是否成功
+     */
+    bool writeEntry(const std::string& filename, const std::string& outputPath, const std::vector<uint8_t>& data) const;
     
     /**
      * @brief 读取索引文件
@@ -115,7 +326,15 @@ private:
      * @param entries 文件条目
      * @return 是否成功
      */
-    bool writeIndex(const std::string& idxFilename, const std::map<std::string, PakEntry>& entries);
+    bool writeIndex(const std::string& idxFilename, const PakEntryTable& entries);
+    
+    /**
+     * @brief 只重写部分条目的索引记录
+     * @param idxFilename 索引文件名
+     * @param indices 条目序号
+     * @return 是否成功
+     */
+    bool writeRecords(const std::string& idxFilename, const std::vector<uint32_t>& indices);
 };
 
 } // namespace file
@@ -0,0 +1,123 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "core/encryption/key_profile.h"
+#include "core/file/pak_file.h"
+#include "core/file/pak_entry_table.h"
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_FILE_EXPORTS
+        #define EAGLS_FILE_API __declspec(dllexport)
+    #else
+        #define EAGLS_FILE_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_FILE_API
+#endif
+
+namespace eagls {
+namespace file {
+
+/**
+ * @brief PAK文件的批量修改事务
+ *
+ * begin时读取一次索引，之后的add、replace、remove只修改内存中的条目表，
+ * 新数据直接写到PAK文件原末尾之后（原索引不引用这部分，原PAK和索引仍然配对可用）。
+ * commit时先把PAK新数据刷到磁盘，再写一次新索引到临时文件并刷到磁盘，最后重命名覆盖原索引。
+ * 在重命名之前中断（进程崩溃或断电）时原索引不变，PAK中被原索引引用的数据也不会被修改；
+ * rollback或未提交就析构时把PAK截断回原大小。
+ */
+class EAGLS_FILE_API PakTransaction {
+public:
+    /**
+     * @brief 构造函数
+     */
+    PakTransaction();
+
+    /**
+     * @brief 析构函数，未提交时回滚
+     */
+    ~PakTransaction();
+
+    PakTransaction(const PakTransaction&) = delete;
+    PakTransaction& operator=(const PakTransaction&) = delete;
+
+    /**
+     * @brief 设置密钥配置，需在begin之前调用
+     * @param profile 密钥配置
+     */
+    void setProfile(const encryption::KeyProfile& profile);
+
+    /**
+     * @brief 开始事务
+     * @param pakFilename PAK文件名（必须已存在）
+     * @return 是否成功
+     */
+    bool begin(const std::string& pakFilename);
+
+    /**
+     * @brief 添加文件，PAK中已有同名条目时失败
+     * @param filename 要添加的文件名
+     * @param encrypt 是否加密
+     * @return 是否成功
+     */
+    bool add(const std::string& filename, bool encrypt = true);
+
+    /**
+     * @brief 替换已有的条目，新数据总是追加，原位置成为空闲空间
+     * @param filename 替换用的文件名，按文件名对应条目
+     * @param encrypt 是否加密
+     * @return 是否成功
+     */
+    bool replace(const std::string& filename, bool encrypt = true);
+
+    /**
+     * @brief 删除条目，原位置成为空闲空间
+     * @param name 条目文件名
+     * @return 是否成功
+     */
+    bool remove(const std::string& name);
+
+    /**
+     * @brief 提交：写入新索引并重命名覆盖原索引
+     * @return 是否成功，失败时事务仍未提交，可以回滚
+     */
+    bool commit();
+
+    /**
+     * @brief 回滚：丢弃所有修改，PAK截断回原大小
+     */
+    void rollback();
+
+    /**
+     * @brief 是否在事务中
+     */
+    bool isActive() const;
+
+private:
+    PakFile m_pak;                      // 原PAK文件（用于读取索引和写索引）
+    std::string m_pakFilename;          // PAK文件名
+    PakEntryTable m_entries;            // 修改后的条目表
+    std::vector<bool> m_removed;        // 条目是否已删除
+    std::ofstream m_pakOut;             // 追加新数据
+    uint64_t m_originalSize;            // PAK文件原大小
+    uint64_t m_tail;                    // 下一个新数据的写入位置
+    bool m_active;                      // 是否在事务中
+
+    /**
+     * @brief 把文件写到PAK末尾
+     * @param filename 文件名
+     * @param encrypt 是否加密
+     * @param offset 输出索引中的偏移
+     * @param size 输出大小
+     * @return 是否成功
+     */
+    bool stage(const std::string& filename, bool encrypt, uint64_t& offset, uint32_t& size);
+};
+
+} // namespace file
+} // namespace eagls
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "core/encryption/key_profile.h"
+
+// DLL导出宏定义
+#ifdef _WIN32
+    #ifdef EAGLS_FILE_EXPORTS
+        #define EAGLS_FILE_API __declspec(dllexport)
+    #else
+        #define EAGLS_FILE_API __declspec(dllimport)
+    #endif
+#else
+    #define EAGLS_FILE_API
+#endif
+
+namespace eagls {
+namespace file {
+
+/**
+ * @brief 单个密钥配置的探测结果
+ */
+struct EAGLS_FILE_API ProfileProbe {
+    std::string profileName;   // 配置名称
+    bool matched;              // 是否匹配
+    size_t recordsChecked;     // 检查过的索引记录数
+    bool imageChecked;         // 是否检查了GR样本
+    std::string reason;        // 不匹配的原因
+};
+
+/**
+ * @brief 密钥配置探测
+ *
+ * 不做完整解包，只用每个配置解密索引开头的若干条记录，检查：
+ *   文件名为可打印字符，记录的数据区间都在PAK文件内且互不重叠；
+ * 再取第一个GR文件的开头一小段，解密并解压出前两个字节，检查是否为BMP标记"BM"。
+ * 只读取几KB数据，通常在几毫秒内完成。
+ */
+class EAGLS_FILE_API ProfileDetector {
+public:
+    static constexpr size_t PROBE_RECORDS = 64;   // 最多检查的索引记录数
+    static constexpr size_t SAMPLE_SIZE = 256;    // GR样本读取的字节数
+
+    /**
+     * @brief 用一个配置探测PAK文件
+     * @param pakFilename PAK文件名（索引文件为同名的.idx）
+     * @param profile 密钥配置
+     * @return 探测结果
+     */
+    static ProfileProbe probe(const std::string& pakFilename, const encryption::KeyProfile& profile);
+
+    /**
+     * @brief 依次用所有已注册的配置探测，选出匹配的配置
+     *
+     * 检查了GR样本的配置优先于只有索引记录合理的配置。
+     * @param pakFilename PAK文件名
+     * @param profile 输出匹配的配置
+     * @param report 可选，输出每个配置的探测结果
+     * @return 是否找到匹配的配置
+     */
+    static bool detect(const std::string& pakFilename, encryption::KeyProfile& profile,
+                       std::vector<ProfileProbe>* report = nullptr);
+};
+
+} // namespace file
+} // namespace eagls
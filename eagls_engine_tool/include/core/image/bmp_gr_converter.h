@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "core/compression/gr_lzss.h"
+#include "core/encryption/key_profile.h"
 
 // DLL导出宏定义
 #ifdef _WIN32
@@ -37,9 +39,11 @@ public:
      * @brief BMP转GR
      * @param bmpFilename BMP文件名
      * @param grFilename GR文件名
+     * @param level 压缩级别
      * @return 是否成功
      */
-    bool bmpToGr(const std::string& bmpFilename, const std::string& grFilename);
+    bool bmpToGr(const std::string& bmpFilename, const std::string& grFilename,
+                 compression::GrLevel level = compression::GrLevel::Bitmap);
     
     /**
      * @brief GR转BMP
@@ -49,13 +53,43 @@ public:
      */
     bool grToBmp(const std::string& grFilename, const std::string& bmpFilename);
     
+    /**
+     * @brief 解密并解压GR数据
+     *
+     * 单遍完成：加密的开头部分在解压时逐块与密钥流异或，其余部分直接从源数据读取，
+     * 不生成解密后的副本。源数据不被修改，可以是文件映射或PAK条目视图。
+     * @param data GR数据
+     * @param size GR数据大小
+     * @param output 输出缓冲区
+     * @param outputSize 输出缓冲区大小
+     * @param profile 密钥配置
+     * @return 实际写入的字节数
+     */
+    static size_t decodeGr(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize,
+                           const encryption::KeyProfile& profile = encryption::KeyProfileRegistry::getDefault());
+    
+    /**
+     * @brief 解密并解压GR数据为BMP
+     *
+     * 先扫描出解压后的大小，一次分配后直接解压到结果中。
+     * @param data GR数据
+     * @param size GR数据大小
+     * @param bmpData 输出BMP数据
+     * @param profile 密钥配置
+     * @return 是否成功（解压结果为有效的BMP）
+     */
+    static bool decodeGr(const uint8_t* data, size_t size, std::vector<uint8_t>& bmpData,
+                         const encryption::KeyProfile& profile = encryption::KeyProfileRegistry::getDefault());
+    
     /**
      * @brief 批量BMP转GR
      * @param inputDir 输入目录
      * @param outputDir 输出目录
+     * @param level 压缩级别
      * @return 成功转换的文件数
      */
-    int batchBmpToGr(const std::string& inputDir, const std::string& outputDir);
+    int batchBmpToGr(const std::string& inputDir, const std::string& outputDir,
+                     compression::GrLevel level = compression::GrLevel::Bitmap);
     
     /**
      * @brief 批量GR转BMP
@@ -65,7 +99,16 @@ public:
      */
     int batchGrToBmp(const std::string& inputDir, const std::string& outputDir);
 
+    /**
+     * @brief 获取最近一次BMP转GR的压缩统计信息
+     * @return 输入/输出大小与耗时
+     */
+    compression::GrEncodeStats getLastStats() const;
+
 private:
+    compression::GrEncodeStats m_lastStats;  // 最近一次压缩的统计信息
+
+
     /**
      * @brief 读取BMP文件
      * @param filename 文件名
@@ -0,0 +1,336 @@
+﻿#include "core/compression/gr_checkpoint.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace eagls {
+namespace compression {
+
+namespace {
+
+const char INDEX_MAGIC[4] = { 'G', 'R', 'C', 'K' };
+const uint32_t INDEX_VERSION = 1;
+const size_t CHECKPOINT_RECORD_SIZE = sizeof(uint64_t) * 2 + sizeof(uint8_t) * 2 + GrLzss::FRAME_SIZE;  // 每个检查点在文件中的大小
+
+template <typename T>
+void writeValue(std::ofstream& file, T value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/**
+ * @brief 从检查点开始解压
+ *
+ * 与GrLzss::decodeInto相同，以输出缓冲区作为历史窗口，
+ * 引用到输出开始之前的数据时改为从检查点的帧快照中读取。
+ */
+size_t decodeFromCheckpoint(const GrCheckpoint& checkpoint, const uint8_t* src, size_t srcSize,
+                            uint8_t* dst, size_t dstSize) {
+    const size_t baseFramePos = (GrLzss::FRAME_INIT_POS + checkpoint.outputOffset) & GrLzss::FRAME_MASK;
+    size_t srcPos = checkpoint.inputOffset;
+    size_t outPos = 0;
+    uint8_t flags = checkpoint.flags;
+    int i = checkpoint.itemIndex;
+
+    while (outPos < dstSize) {
+        // 读取新的标记字节
+        if (i >= 8) {
+            if (srcPos >= srcSize) {
+                break;
+            }
+            flags = src[srcPos++];
+            i = 0;
+
+            // 整组都是原始字节时直接整块复制
+            if (flags == 0xFF && srcSize - srcPos >= 8 && dstSize - outPos >= 8) {
+                std::memcpy(dst + outPos, src + srcPos, 8);
+                srcPos += 8;
+                outPos += 8;
+                i = 8;
+                continue;
+            }
+        }
+
+        if (flags & (1 << i)) {
+            // 原始数据
+            if (srcPos >= srcSize) {
+                break;
+            }
+            dst[outPos++] = src[srcPos++];
+        } else {
+            // 压缩数据
+            if (srcPos + 1 >= srcSize) {
+                break;  // 数据不足
+            }
+            uint8_t lo = src[srcPos++];
+            uint8_t hi = src[srcPos++];
+            size_t offset = (static_cast<size_t>(hi & 0xF0) << 4) | lo;
+            size_t count = std::min(static_cast<size_t>(hi & 0x0F) + GrLzss::MIN_MATCH, dstSize - outPos);
+
+            size_t distance = (baseFramePos + outPos - offset) & GrLzss::FRAME_MASK;
+            if (distance == 0) {
+                distance = GrLzss::FRAME_SIZE;
+            }
+
+            uint8_t* out = dst + outPos;
+            if (distance > outPos) {
+                // 引用了检查点之前的数据，从帧快照中读取
+                for (size_t j = 0; j < count; ++j) {
+                    out[j] = (outPos + j >= distance)
+                        ? dst[outPos + j - distance]
+                        : checkpoint.frame[(baseFramePos + outPos + j - distance) & GrLzss::FRAME_MASK];
+                }
+            } else if (distance >= count) {
+                std::memcpy(out, out - distance, count);
+            } else {
+                const uint8_t* from = out - distance;
+                for (size_t j = 0; j < count; ++j) {
+                    out[j] = from[j];
+                }
+            }
+            outPos += count;
+        }
+        ++i;
+    }
+
+    return outPos;
+}
+
+} // namespace
+
+GrCheckpointIndex::GrCheckpointIndex()
+    : m_interval(DEFAULT_INTERVAL), m_decodedSize(0), m_compressedSize(0) {
+}
+
+bool GrCheckpointIndex::build(const uint8_t* src, size_t srcSize, size_t interval) {
+    if (interval == 0) {
+        std::cerr << "Error: Invalid checkpoint interval" << std::endl;
+        return false;
+    }
+
+    m_interval = interval;
+    m_checkpoints.clear();
+
+    GrCheckpoint state;
+    std::memset(&state, 0, sizeof(state));
+    state.itemIndex = 8;
+    size_t framePos = GrLzss::FRAME_INIT_POS;
+    size_t srcPos = 0;
+    size_t outPos = 0;
+    size_t nextMark = 0;
+
+    while (srcPos < srcSize) {
+        // 到达间隔后在项目边界处保存检查点
+        if (outPos >= nextMark) {
+            state.outputOffset = outPos;
+            state.inputOffset = srcPos;
+            m_checkpoints.push_back(state);
+            nextMark = (outPos / interval + 1) * interval;
+        }
+
+        if (state.itemIndex >= 8) {
+            state.flags = src[srcPos++];
+            state.itemIndex = 0;
+        }
+
+        if (state.flags & (1 << state.itemIndex)) {
+            if (srcPos >= srcSize) {
+                break;
+            }
+            state.frame[framePos] = src[srcPos++];
+            framePos = (framePos + 1) & GrLzss::FRAME_MASK;
+            ++outPos;
+        } else {
+            if (srcPos + 1 >= srcSize) {
+                break;
+            }
+            uint8_t lo = src[srcPos++];
+            uint8_t hi = src[srcPos++];
+            size_t offset = (static_cast<size_t>(hi & 0xF0) << 4) | lo;
+            size_t count = (hi & 0x0F) + GrLzss::MIN_MATCH;
+            for (size_t j = 0; j < count; ++j) {
+                state.frame[framePos] = state.frame[(offset + j) & GrLzss::FRAME_MASK];
+                framePos = (framePos + 1) & GrLzss::FRAME_MASK;
+            }
+            outPos += count;
+        }
+        ++state.itemIndex;
+    }
+
+    m_decodedSize = outPos;
+    m_compressedSize = srcSize;
+    return true;
+}
+
+bool GrCheckpointIndex::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot create checkpoint index: " << filename << std::endl;
+        return false;
+    }
+
+    // 文件头
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    writeValue<uint32_t>(file, INDEX_VERSION);
+    writeValue<uint32_t>(file, static_cast<uint32_t>(m_interval));
+    writeValue<uint32_t>(file, static_cast<uint32_t>(m_checkpoints.size()));
+    writeValue<uint64_t>(file, m_decodedSize);
+    writeValue<uint64_t>(file, m_compressedSize);
+
+    // 检查点
+    for (const auto& checkpoint : m_checkpoints) {
+        writeValue<uint64_t>(file, checkpoint.outputOffset);
+        writeValue<uint64_t>(file, checkpoint.inputOffset);
+        writeValue<uint8_t>(file, checkpoint.flags);
+        writeValue<uint8_t>(file, checkpoint.itemIndex);
+        file.write(reinterpret_cast<const char*>(checkpoint.frame), sizeof(checkpoint.frame));
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool GrCheckpointIndex::load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open checkpoint index: " << filename << std::endl;
+        return false;
+    }
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint32_t interval = 0;
+    uint32_t count = 0;
+    uint64_t decodedSize = 0;
+    uint64_t compressedSize = 0;
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+        !readValue(file, version) || version != INDEX_VERSION ||
+        !readValue(file, interval) || !readValue(file, count) ||
+        !readValue(file, decodedSize) || !readValue(file, compressedSize) || interval == 0) {
+        std::cerr << "Error: Invalid checkpoint index: " << filename << std::endl;
+        return false;
+    }
+
+    // 先用剩余文件大小检查数量，避免损坏的数量导致分配失败
+    const std::streamoff headerEnd = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileEnd = file.tellg();
+    file.seekg(headerEnd);
+    if (headerEnd < 0 || fileEnd < headerEnd ||
+        count > static_cast<uint64_t>(fileEnd - headerEnd) / CHECKPOINT_RECORD_SIZE) {
+        std::cerr << "Error: Truncated checkpoint index: " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<GrCheckpoint> checkpoints(count);
+    for (auto& checkpoint : checkpoints) {
+        if (!readValue(file, checkpoint.outputOffset) || !readValue(file, checkpoint.inputOffset) ||
+            !readValue(file, checkpoint.flags) || !readValue(file, checkpoint.itemIndex) ||
+            !file.read(reinterpret_cast<char*>(checkpoint.frame), sizeof(checkpoint.frame))) {
+            std::cerr << "Error: Truncated checkpoint index: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    // decodeRange依赖这些条件：第一个检查点在开头，偏移严格递增且都在数据范围内
+    for (size_t i = 0; i < checkpoints.size(); ++i) {
+        const GrCheckpoint& checkpoint = checkpoints[i];
+        const bool ordered = (i == 0) ? checkpoint.outputOffset == 0
+            : checkpoint.outputOffset > checkpoints[i - 1].outputOffset &&
+              checkpoint.inputOffset >= checkpoints[i - 1].inputOffset;
+        if (!ordered || checkpoint.outputOffset > decodedSize ||
+            checkpoint.inputOffset > compressedSize || checkpoint.itemIndex > 8) {
+            std::cerr << "Error: Invalid checkpoint " << i << " in index: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    m_interval = interval;
+    m_decodedSize = decodedSize;
+    m_compressedSize = compressedSize;
+    m_checkpoints.swap(checkpoints);
+    return true;
+}
+
+size_t GrCheckpointIndex::decodeRange(const uint8_t* src, size_t srcSize, size_t outputOffset,
+                                      uint8_t* dst, size_t dstSize, int threadCount) const {
+    if (m_checkpoints.empty() || srcSize != m_compressedSize) {
+        std::cerr << "Error: Checkpoint index does not match compressed data" << std::endl;
+        return 0;
+    }
+    if (outputOffset >= m_decodedSize || dstSize == 0) {
+        return 0;
+    }
+    const size_t end = outputOffset + static_cast<size_t>(std::min<uint64_t>(dstSize, m_decodedSize - outputOffset));
+
+    // 范围覆盖的检查点段 [first, last)
+    auto byOffset = [](const GrCheckpoint& checkpoint, size_t value) { return checkpoint.outputOffset < value; };
+    auto first = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), outputOffset,
+        [](size_t value, const GrCheckpoint& checkpoint) { return value < checkpoint.outputOffset; }) - 1;
+    auto last = std::lower_bound(first, m_checkpoints.end(), end, byOffset);
+    const size_t segmentCount = static_cast<size_t>(last - first);
+
+    auto decodeSegment = [&](size_t s) {
+        const GrCheckpoint& checkpoint = first[s];
+        const size_t segmentEnd = (first + s + 1 == m_checkpoints.end())
+            ? end : std::min<size_t>(end, static_cast<size_t>(first[s + 1].outputOffset));
+
+        if (checkpoint.outputOffset < outputOffset) {
+            // 起始偏移不在检查点上，先解压到临时缓冲区再复制需要的部分
+            std::vector<uint8_t> scratch(segmentEnd - static_cast<size_t>(checkpoint.outputOffset));
+            decodeFromCheckpoint(checkpoint, src, srcSize, scratch.data(), scratch.size());
+            const size_t skip = outputOffset - static_cast<size_t>(checkpoint.outputOffset);
+            std::memcpy(dst, scratch.data() + skip, segmentEnd - outputOffset);
+        } else {
+            const size_t begin = static_cast<size_t>(checkpoint.outputOffset);
+            decodeFromCheckpoint(checkpoint, src, srcSize, dst + (begin - outputOffset), segmentEnd - begin);
+        }
+    };
+
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    const size_t workerCount = std::min(segmentCount, static_cast<size_t>(std::max(threadCount, 1)));
+
+    if (workerCount <= 1) {
+        for (size_t s = 0; s < segmentCount; ++s) {
+            decodeSegment(s);
+        }
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount);
+        for (size_t w = 0; w < workerCount; ++w) {
+            workers.emplace_back([&, w]() {
+                for (size_t s = w; s < segmentCount; s += workerCount) {
+                    decodeSegment(s);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    return end - outputOffset;
+}
+
+size_t GrCheckpointIndex::getDecodedSize() const {
+    return static_cast<size_t>(m_decodedSize);
+}
+
+const std::vector<GrCheckpoint>& GrCheckpointIndex::getCheckpoints() const {
+    return m_checkpoints;
+}
+
+std::string GrCheckpointIndex::getIndexFilename(const std::string& grFilename) {
+    return grFilename + ".grx";
+}
+
+} // namespace compression
+} // namespace eagls
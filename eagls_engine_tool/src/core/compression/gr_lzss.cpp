@@ -0,0 +1,1116 @@
+﻿#include "core/compression/gr_lzss.h"
+#include "gr_window_search.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+namespace eagls {
+namespace compression {
+
+namespace {
+
+// 哈希链匹配查找器参数
+constexpr int HASH_BITS = 15;                  // 3字节前缀哈希表位数
+constexpr uint32_t HASH_SIZE = 1u << HASH_BITS;
+constexpr int32_t NIL = -1;                    // 空链接
+
+inline uint32_t hash3(const uint8_t* p) {
+    uint32_t v = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief 哈希链匹配查找器
+ *
+ * 工作在"4KB全0前导 + 输入数据"组成的历史缓冲区上，前导正好对应解码器初始的全0帧，
+ * 所以历史位置q对应的帧偏移为 (q + FRAME_INIT_POS) & FRAME_MASK。
+ * 链接数组是按 q & FRAME_MASK 寻址的4KB固定环形缓冲区。
+ * 必须先对位置q调用find，再调用insert(q)。
+ */
+class HashChainMatchFinder {
+public:
+    HashChainMatchFinder(const uint8_t* buf, size_t size, int maxChainDepth)
+        : m_buf(buf),
+          m_size(size),
+          m_maxChainDepth(maxChainDepth),
+          m_head(HASH_SIZE, NIL),
+          m_prev(GrLzss::FRAME_SIZE, NIL) {
+    }
+
+    void insert(size_t pos) {
+        if (pos + 2 >= m_size) {
+            return;
+        }
+        uint32_t h = hash3(m_buf + pos);
+        m_prev[pos & GrLzss::FRAME_MASK] = m_head[h];
+        m_head[h] = static_cast<int32_t>(pos);
+    }
+
+    // 返回最长匹配长度，不足MIN_MATCH时返回0；
+    // knownLength为调用者已有的匹配长度，只查找比它更长的匹配，找不到时返回值不超过它且不修改matchPos；
+    // depthReached不为空时，输出是否因达到搜索深度而停止（此时结果不一定是窗口内的最长匹配）
+    size_t find(size_t pos, size_t& matchPos, size_t knownLength = 0, bool* depthReached = nullptr) const {
+        if (depthReached) {
+            *depthReached = false;
+        }
+        const size_t maxLength = std::min(GrLzss::MAX_MATCH, m_size - pos);
+        if (maxLength < GrLzss::MIN_MATCH || knownLength >= maxLength) {
+            return 0;
+        }
+
+        // 可引用的范围为当前位置之前的4KB，允许匹配串与当前位置重叠
+        const size_t windowStart = pos - GrLzss::FRAME_SIZE;
+        size_t best = knownLength;
+
+        int32_t cand = m_head[hash3(m_buf + pos)];
+        for (int depth = 0; cand != NIL; ++depth) {
+            if (depth >= m_maxChainDepth) {
+                if (depthReached) {
+                    *depthReached = true;
+                }
+                break;
+            }
+            size_t candPos = static_cast<size_t>(cand);
+            if (candPos < windowStart) {
+                break;
+            }
+
+            if (m_buf[candPos + best] == m_buf[pos + best]) {
+                size_t len = 0;
+                while (len < maxLength && m_buf[candPos + len] == m_buf[pos + len]) {
+                    ++len;
+                }
+                if (len > best) {
+                    best = len;
+                    matchPos = candPos;
+                    if (len == maxLength) {
+                        break;
+                    }
+                }
+            }
+
+            cand = m_prev[candPos & GrLzss::FRAME_MASK];
+        }
+
+        return best >= GrLzss::MIN_MATCH ? best : 0;
+    }
+
+    // 插入 [from, to) 范围内的位置，用于在任意位置重建与顺序压缩一致的哈希链
+    void warmUp(size_t from, size_t to) {
+        for (size_t pos = std::max(from, PRELOAD_START); pos < to; ++pos) {
+            insert(pos);
+        }
+    }
+
+    // 与原始编码器相同，只预先插入前导末尾的MAX_MATCH个位置
+    static constexpr size_t PRELOAD_START = GrLzss::FRAME_SIZE - GrLzss::MAX_MATCH;
+
+private:
+    const uint8_t* m_buf;
+    size_t m_size;
+    int m_maxChainDepth;
+    std::vector<int32_t> m_head;
+    std::vector<int32_t> m_prev;
+};
+
+/**
+ * @brief 解析得到的一个编码项目
+ */
+struct GrItem {
+    uint32_t pos;     // 历史缓冲区中的位置
+    uint16_t length;  // 1表示原始字节
+    uint16_t offset;  // 帧偏移
+};
+
+/**
+ * @brief 编码项目输出器，每8个项目写一个标记字节
+ */
+class ItemWriter {
+public:
+    ItemWriter(const uint8_t* history, uint8_t* out)
+        : m_history(history), m_out(out), m_outPos(0), m_flagPos(0), m_itemnum(0) {
+    }
+
+    void write(const GrItem& item) {
+        // 每组开始时预留标记字节
+        if (m_itemnum == 0) {
+            m_flagPos = m_outPos;
+            m_out[m_outPos++] = 0;
+        }
+
+        if (item.length >= GrLzss::MIN_MATCH) {
+            // 12位帧偏移 + 4位(长度-3)
+            m_out[m_outPos++] = static_cast<uint8_t>(item.offset & 0xFF);
+            m_out[m_outPos++] = static_cast<uint8_t>(((item.offset >> 4) & 0xF0) | (item.length - GrLzss::MIN_MATCH));
+        } else {
+            // 原始数据，设置标志位
+            m_out[m_outPos++] = m_history[item.pos];
+            m_out[m_flagPos] |= static_cast<uint8_t>(1 << m_itemnum);
+        }
+
+        // 处理了8个项目后开始新的一组
+        if (++m_itemnum >= 8) {
+            m_itemnum = 0;
+        }
+    }
+
+    size_t size() const {
+        return m_outPos;
+    }
+
+private:
+    const uint8_t* m_history;
+    uint8_t* m_out;
+    size_t m_outPos;
+    size_t m_flagPos;
+    int m_itemnum;
+};
+
+// 在当前位置查找匹配并更新哈希链，返回该位置的编码项目
+inline GrItem nextGreedyItem(HashChainMatchFinder& finder, size_t pos) {
+    size_t matchPos = 0;
+    size_t matchLength = finder.find(pos, matchPos);
+
+    GrItem item;
+    item.pos = static_cast<uint32_t>(pos);
+    item.length = static_cast<uint16_t>(matchLength >= GrLzss::MIN_MATCH ? matchLength : 1);
+    item.offset = static_cast<uint16_t>((matchPos + GrLzss::FRAME_INIT_POS) & GrLzss::FRAME_MASK);
+
+    for (size_t i = 0; i < item.length; ++i) {
+        finder.insert(pos + i);
+    }
+    return item;
+}
+
+// 每个线程至少处理的输入字节数，过小的块不值得并行
+constexpr size_t MIN_PARALLEL_CHUNK = 64 * 1024;
+
+// 最优解析的代价（比特）：每个项目另占标记字节中的1位
+constexpr uint32_t LITERAL_COST = 9;
+constexpr uint32_t MATCH_COST = 17;
+
+// 最优解析使用WindowScan时，哈希链超过此深度仍未找到最大长度就改为向量化比较整个窗口
+constexpr int WINDOW_SCAN_CHAIN_DEPTH = 16;
+
+// 位图模式记住的最近匹配距离个数
+constexpr size_t RECENT_DISTANCES = 2;
+
+// 对 [0, count) 的每个块调用fn，多于一个块时每块一个线程
+template <typename Fn>
+void runChunks(size_t count, Fn fn) {
+    if (count <= 1) {
+        fn(0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+    for (size_t k = 0; k < count; ++k) {
+        workers.emplace_back(fn, k);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// 把 [FRAME_SIZE, end) 均分为chunkCount块
+std::vector<size_t> chunkBounds(size_t end, size_t chunkCount) {
+    const size_t size = end - GrLzss::FRAME_SIZE;
+    std::vector<size_t> bounds(chunkCount + 1);
+    for (size_t k = 0; k <= chunkCount; ++k) {
+        bounds[k] = GrLzss::FRAME_SIZE + size * k / chunkCount;
+    }
+    return bounds;
+}
+
+/**
+ * @brief 贪心解析：每个位置取最长匹配
+ *
+ * 某个位置的匹配只取决于它之前4KB的输入，与之前的解析选择无关，
+ * 所以每个块可以在独立的线程中从块起点开始解析，再顺序拼接。
+ */
+void encodeGreedy(const uint8_t* history, size_t end, int maxChainDepth, size_t chunkCount, ItemWriter& writer) {
+    if (chunkCount <= 1) {
+        HashChainMatchFinder finder(history, end, maxChainDepth);
+        finder.warmUp(0, GrLzss::FRAME_SIZE);
+
+        size_t pos = GrLzss::FRAME_SIZE;
+        while (pos < end) {
+            GrItem item = nextGreedyItem(finder, pos);
+            writer.write(item);
+            pos += item.length;
+        }
+        return;
+    }
+
+    const std::vector<size_t> bounds = chunkBounds(end, chunkCount);
+    std::vector<std::vector<GrItem>> chunkItems(chunkCount);
+
+    runChunks(chunkCount, [&](size_t k) {
+        HashChainMatchFinder finder(history, end, maxChainDepth);
+        finder.warmUp(bounds[k] - GrLzss::FRAME_SIZE, bounds[k]);
+
+        std::vector<GrItem>& items = chunkItems[k];
+        items.reserve((bounds[k + 1] - bounds[k]) / 4);
+
+        size_t pos = bounds[k];
+        while (pos < bounds[k + 1]) {
+            GrItem item = nextGreedyItem(finder, pos);
+            items.push_back(item);
+            pos += item.length;
+        }
+    });
+
+    // 顺序拼接：上一块的最后一个匹配可能越过块边界，
+    // 此时从实际位置继续解析，直到与本块的解析结果重合
+    size_t pos = GrLzss::FRAME_SIZE;
+    for (size_t k = 0; k < chunkCount; ++k) {
+        const std::vector<GrItem>& items = chunkItems[k];
+        auto it = std::lower_bound(items.begin(), items.end(), pos,
+            [](const GrItem& item, size_t value) { return item.pos < value; });
+
+        if ((it == items.end() || it->pos != pos) && pos < bounds[k + 1]) {
+            HashChainMatchFinder finder(history, end, maxChainDepth);
+            finder.warmUp(pos - GrLzss::FRAME_SIZE, pos);
+
+            bool synced = false;
+            while (pos < bounds[k + 1]) {
+                while (it != items.end() && it->pos < pos) {
+                    ++it;
+                }
+                if (it != items.end() && it->pos == pos) {
+                    synced = true;
+                    break;
+                }
+                GrItem item = nextGreedyItem(finder, pos);
+                writer.write(item);
+                pos += item.length;
+            }
+
+            // 直到块末尾都没有重合，本块的结果全部作废
+            if (!synced) {
+                it = items.end();
+            }
+        }
+
+        for (; it != items.end(); ++it) {
+            writer.write(*it);
+            pos = it->pos + it->length;
+        }
+    }
+}
+
+/**
+ * @brief 最优解析：使输出总比特数最小
+ *
+ * 所有匹配的代价相同，某位置的最长匹配包含了同一偏移上所有更短的长度，
+ * 所以只需要每个位置在整个4KB窗口内的最长匹配（可分块并行计算），
+ * 再从后向前动态规划求出最小代价的项目序列。
+ * 使用WindowScan时先查一小段哈希链，链过长（大量相同前缀但都不够长）时改为向量化比较整个窗口，
+ * 避免逐个走完几千个候选，结果同样是窗口内的最长匹配。
+ */
+void encodeOptimal(const uint8_t* history, size_t end, size_t chunkCount, GrMatchFinder matchFinder,
+                   ItemWriter& writer) {
+    const bool windowScan = (matchFinder == GrMatchFinder::WindowScan);
+    const size_t size = end - GrLzss::FRAME_SIZE;
+    std::vector<uint8_t> lengths(size);
+    std::vector<uint16_t> offsets(size);
+
+    const detail::WindowSearchFn search = windowScan ? detail::selectWindowSearch() : nullptr;
+    const std::vector<size_t> bounds = chunkBounds(end, std::max<size_t>(chunkCount, 1));
+    runChunks(bounds.size() - 1, [&](size_t k) {
+        HashChainMatchFinder finder(history, end,
+            windowScan ? WINDOW_SCAN_CHAIN_DEPTH : static_cast<int>(GrLzss::FRAME_SIZE));
+        finder.warmUp(bounds[k] - GrLzss::FRAME_SIZE, bounds[k]);
+
+        for (size_t pos = bounds[k]; pos < bounds[k + 1]; ++pos) {
+            size_t matchPos = 0;
+            size_t i = pos - GrLzss::FRAME_SIZE;
+            bool depthReached = false;
+            size_t length = finder.find(pos, matchPos, 0, &depthReached);
+            if (windowScan && depthReached) {
+                length = search(history, pos, std::min(GrLzss::MAX_MATCH, end - pos), matchPos, length);
+            }
+            lengths[i] = static_cast<uint8_t>(length);
+            offsets[i] = static_cast<uint16_t>((matchPos + GrLzss::FRAME_INIT_POS) & GrLzss::FRAME_MASK);
+            finder.insert(pos);
+        }
+    });
+
+    // cost[i]为从i开始编码剩余数据的最小比特数；
+    // lengths[i]用完后改存该位置选择的项目长度
+    std::vector<uint32_t> cost(size + 1, 0);
+    for (size_t i = size; i-- > 0;) {
+        uint32_t best = cost[i + 1] + LITERAL_COST;
+        uint8_t choice = 1;
+        for (size_t len = lengths[i]; len >= GrLzss::MIN_MATCH; --len) {
+            uint32_t c = cost[i + len] + MATCH_COST;
+            if (c < best) {
+                best = c;
+                choice = static_cast<uint8_t>(len);
+            }
+        }
+        cost[i] = best;
+        lengths[i] = choice;
+    }
+
+    size_t i = 0;
+    while (i < size) {
+        GrItem item;
+        item.pos = static_cast<uint32_t>(i + GrLzss::FRAME_SIZE);
+        item.length = lengths[i];
+        item.offset = offsets[i];
+        writer.write(item);
+        i += item.length;
+    }
+}
+
+/**
+ * @brief 从BMP头取得每行字节数和每像素字节数
+ * @return 不是可识别的未压缩BMP时返回false
+ */
+bool parseBitmapLayout(const uint8_t* data, size_t size, size_t& stride, size_t& pixelSize) {
+    // BITMAPFILEHEADER(14字节) + BITMAPINFOHEADER中的biWidth(偏移18)、biBitCount(偏移28)、biCompression(偏移30)
+    if (size < 34 || data[0] != 'B' || data[1] != 'M') {
+        return false;
+    }
+    int32_t width = 0;
+    uint16_t bitCount = 0;
+    uint32_t compression = 0;
+    std::memcpy(&width, data + 18, sizeof(width));
+    std::memcpy(&bitCount, data + 28, sizeof(bitCount));
+    std::memcpy(&compression, data + 30, sizeof(compression));
+    if (width <= 0 || bitCount == 0 || compression != 0) {
+        return false;
+    }
+
+    stride = ((static_cast<size_t>(width) * bitCount + 31) / 32) * 4;
+    pixelSize = std::max<size_t>(bitCount / 8, 1);
+    return true;
+}
+
+/**
+ * @brief 位图感知的贪心解析
+ *
+ * 先探测上一行、上一像素和最近用过的距离，再用探测到的长度作为起点查哈希链，
+ * 链上只有更长的匹配才会被比较。探测直接得到最大长度时跳过哈希链，
+ * 且匹配内部的位置不再插入哈希链（大块同色区域正是这种情况，之后同样能被探测到）。
+ * 最近距离依赖之前的解析结果，因此只能单线程执行。
+ */
+void encodeBitmap(const uint8_t* history, size_t end, size_t stride, size_t pixelSize, int maxChainDepth,
+                  ItemWriter& writer) {
+    HashChainMatchFinder finder(history, end, maxChainDepth);
+    finder.warmUp(0, GrLzss::FRAME_SIZE);
+
+    size_t recent[RECENT_DISTANCES] = {};
+    size_t pos = GrLzss::FRAME_SIZE;
+    while (pos < end) {
+        const size_t maxLength = std::min(GrLzss::MAX_MATCH, end - pos);
+        const uint8_t* cur = history + pos;
+        size_t best = 0;
+        size_t bestDistance = 0;
+
+        // 候选距离：上一行、上一像素、最近用过的距离
+        size_t candidates[2 + RECENT_DISTANCES] = { stride, pixelSize };
+        std::copy(recent, recent + RECENT_DISTANCES, candidates + 2);
+        for (size_t distance : candidates) {
+            if (distance == 0 || distance > GrLzss::FRAME_SIZE) {
+                continue;
+            }
+            const uint8_t* ref = cur - distance;
+            if (ref[best] != cur[best]) {
+                continue;  // 不可能比当前最长的更长
+            }
+            size_t len = 0;
+            while (len < maxLength && ref[len] == cur[len]) {
+                ++len;
+            }
+            if (len > best) {
+                best = len;
+                bestDistance = distance;
+                if (len == maxLength) {
+                    break;
+                }
+            }
+        }
+
+        const bool probeHit = (best == maxLength);
+        if (!probeHit) {
+            size_t matchPos = 0;
+            size_t len = finder.find(pos, matchPos, best);
+            if (len > best) {
+                best = len;
+                bestDistance = pos - matchPos;
+            }
+        }
+
+        GrItem item;
+        item.pos = static_cast<uint32_t>(pos);
+        if (best >= GrLzss::MIN_MATCH) {
+            item.length = static_cast<uint16_t>(best);
+            item.offset = static_cast<uint16_t>((pos - bestDistance + GrLzss::FRAME_INIT_POS) & GrLzss::FRAME_MASK);
+
+            // 最近距离按最近使用排序
+            size_t k = 0;
+            while (k + 1 < RECENT_DISTANCES && recent[k] != bestDistance) {
+                ++k;
+            }
+            for (; k > 0; --k) {
+                recent[k] = recent[k - 1];
+            }
+            recent[0] = bestDistance;
+        } else {
+            item.length = 1;
+            item.offset = 0;
+        }
+        writer.write(item);
+
+        const size_t inserted = probeHit ? 1 : item.length;
+        for (size_t i = 0; i < inserted; ++i) {
+            finder.insert(pos + i);
+        }
+        pos += item.length;
+    }
+}
+
+/**
+ * @brief 原版编码器使用的二叉树匹配查找（Okumura lzss.c）
+ *
+ * 初始写入位置0xfee正是该实现的 N - F，帧初始内容改为0。
+ * 解析规则与之相同：每个位置取树中先找到的最长匹配，长度达到18时改用最新的位置；
+ * 匹配之后跳过的位置同样插入树中。
+ */
+class BinaryTreeMatchFinder {
+public:
+    static constexpr int N = static_cast<int>(GrLzss::FRAME_SIZE);
+    static constexpr int F = static_cast<int>(GrLzss::MAX_MATCH);
+    static constexpr int NIL = N;
+
+    BinaryTreeMatchFinder()
+        : m_text(N + F - 1, 0), m_lson(N + 1, NIL), m_rson(N + 257, NIL), m_dad(N + 1, NIL),
+          m_matchPosition(0), m_matchLength(0) {
+    }
+
+    void insert(int r) {
+        int cmp = 1;
+        const uint8_t* key = &m_text[r];
+        int p = N + 1 + key[0];
+        m_rson[r] = m_lson[r] = NIL;
+        m_matchLength = 0;
+
+        for (;;) {
+            if (cmp >= 0) {
+                if (m_rson[p] != NIL) {
+                    p = m_rson[p];
+                } else {
+                    m_rson[p] = r;
+                    m_dad[r] = p;
+                    return;
+                }
+            } else {
+                if (m_lson[p] != NIL) {
+                    p = m_lson[p];
+                } else {
+                    m_lson[p] = r;
+                    m_dad[r] = p;
+                    return;
+                }
+            }
+
+            int i;
+            for (i = 1; i < F; ++i) {
+                if ((cmp = key[i] - m_text[p + i]) != 0) {
+                    break;
+                }
+            }
+            if (i > m_matchLength) {
+                m_matchPosition = p;
+                if ((m_matchLength = i) >= F) {
+                    break;
+                }
+            }
+        }
+
+        // 完全相同的串：用新节点替换旧节点
+        m_dad[r] = m_dad[p];
+        m_lson[r] = m_lson[p];
+        m_rson[r] = m_rson[p];
+        m_dad[m_lson[p]] = r;
+        m_dad[m_rson[p]] = r;
+        if (m_rson[m_dad[p]] == p) {
+            m_rson[m_dad[p]] = r;
+        } else {
+            m_lson[m_dad[p]] = r;
+        }
+        m_dad[p] = NIL;
+    }
+
+    void remove(int p) {
+        if (m_dad[p] == NIL) {
+            return;
+        }
+
+        int q;
+        if (m_rson[p] == NIL) {
+            q = m_lson[p];
+        } else if (m_lson[p] == NIL) {
+            q = m_rson[p];
+        } else {
+            q = m_lson[p];
+            if (m_rson[q] != NIL) {
+                do {
+                    q = m_rson[q];
+                } while (m_rson[q] != NIL);
+                m_rson[m_dad[q]] = m_lson[q];
+                m_dad[m_lson[q]] = m_dad[q];
+                m_lson[q] = m_lson[p];
+                m_dad[m_lson[p]] = q;
+            }
+            m_rson[q] = m_rson[p];
+            m_dad[m_rson[p]] = q;
+        }
+        m_dad[q] = m_dad[p];
+        if (m_rson[m_dad[p]] == p) {
+            m_rson[m_dad[p]] = q;
+        } else {
+            m_lson[m_dad[p]] = q;
+        }
+        m_dad[p] = NIL;
+    }
+
+    // 写入环形缓冲区，前F-1个字节在末尾留一份副本以便比较时不必回绕
+    void put(int pos, uint8_t c) {
+        m_text[pos] = c;
+        if (pos < F - 1) {
+            m_text[pos + N] = c;
+        }
+    }
+
+    int matchPosition() const {
+        return m_matchPosition;
+    }
+
+    int matchLength() const {
+        return m_matchLength;
+    }
+
+private:
+    std::vector<uint8_t> m_text;
+    std::vector<int> m_lson;
+    std::vector<int> m_rson;
+    std::vector<int> m_dad;
+    int m_matchPosition;
+    int m_matchLength;
+};
+
+/**
+ * @brief 原版编码器的解析
+ *
+ * 逐步复现Okumura lzss.c的Encode()，包括数据末尾匹配长度的截断，
+ * 以保证解压后重新压缩原版GR能得到相同的字节。
+ */
+void encodeOriginal(const uint8_t* history, size_t end, ItemWriter& writer) {
+    constexpr int N = BinaryTreeMatchFinder::N;
+    constexpr int F = BinaryTreeMatchFinder::F;
+    const uint8_t* data = history + GrLzss::FRAME_SIZE;
+    const size_t size = end - GrLzss::FRAME_SIZE;
+
+    BinaryTreeMatchFinder tree;
+    size_t readPos = 0;
+    int s = 0;
+    int r = N - F;
+
+    int len = 0;
+    while (len < F && readPos < size) {
+        tree.put(r + len, data[readPos++]);
+        ++len;
+    }
+    for (int i = 1; i <= F; ++i) {
+        tree.insert(r - i);
+    }
+    tree.insert(r);
+
+    size_t pos = GrLzss::FRAME_SIZE;
+    int matchLength = tree.matchLength();
+    do {
+        if (matchLength > len) {
+            matchLength = len;
+        }
+
+        GrItem item;
+        item.pos = static_cast<uint32_t>(pos);
+        if (matchLength < static_cast<int>(GrLzss::MIN_MATCH)) {
+            matchLength = 1;
+            item.length = 1;
+            item.offset = 0;
+        } else {
+            item.length = static_cast<uint16_t>(matchLength);
+            item.offset = static_cast<uint16_t>(tree.matchPosition());
+        }
+        writer.write(item);
+        pos += item.length;
+
+        const int lastMatchLength = matchLength;
+        int i = 0;
+        for (; i < lastMatchLength && readPos < size; ++i) {
+            tree.remove(s);
+            tree.put(s, data[readPos++]);
+            s = (s + 1) & (N - 1);
+            r = (r + 1) & (N - 1);
+            tree.insert(r);
+        }
+        while (i++ < lastMatchLength) {
+            tree.remove(s);
+            s = (s + 1) & (N - 1);
+            r = (r + 1) & (N - 1);
+            if (--len) {
+                tree.insert(r);
+            }
+        }
+        matchLength = tree.matchLength();
+    } while (len > 0);
+}
+
+} // namespace
+
+GrLzss::GrLzss(int maxChainDepth)
+    : maxChainDepth(maxChainDepth > 0 ? maxChainDepth : 1),
+      threadCount(1),
+      level(GrLevel::Greedy),
+      matchFinder(GrMatchFinder::HashChain),
+      lastStats{0, 0, 0.0} {
+}
+
+void GrLzss::setThreadCount(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    this->threadCount = threadCount > 0 ? threadCount : 1;
+}
+
+void GrLzss::setLevel(GrLevel level) {
+    this->level = level;
+}
+
+void GrLzss::setMatchFinder(GrMatchFinder matchFinder) {
+    this->matchFinder = matchFinder;
+}
+
+GrEncodeStats GrLzss::getLastStats() const {
+    return lastStats;
+}
+
+std::vector<uint8_t> GrLzss::encode(const std::vector<uint8_t>& data) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<uint8_t> result;
+    lastStats = {data.size(), 0, 0.0};
+
+    // 如果输入数据为空，直接返回空结果
+    if (data.empty()) {
+        return result;
+    }
+
+    const size_t size = data.size();
+
+    if (level == GrLevel::Store) {
+        // 每组标记字节0xFF后跟8个原始字节
+        result.resize(size + (size + 7) / 8);
+        size_t outPos = 0;
+        for (size_t pos = 0; pos < size; pos += 8) {
+            size_t count = std::min<size_t>(8, size - pos);
+            result[outPos++] = static_cast<uint8_t>((1u << count) - 1);
+            std::memcpy(result.data() + outPos, data.data() + pos, count);
+            outPos += count;
+        }
+
+        lastStats.outputSize = result.size();
+        lastStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+    // 历史缓冲区：4KB全0前导 + 输入数据
+    // 末尾另留出向量化窗口查找越界读取的空间
+    const size_t end = FRAME_SIZE + size;
+    std::vector<uint8_t> history(end + detail::WINDOW_SEARCH_PADDING, 0);
+    std::memcpy(history.data() + FRAME_SIZE, data.data(), size);
+
+    // 最坏情况：全部为原始数据，每8个项目多一个标记字节
+    result.resize(size + size / 8 + 1);
+    ItemWriter writer(history.data(), result.data());
+
+    size_t chunkCount = std::min(static_cast<size_t>(threadCount), size / MIN_PARALLEL_CHUNK);
+
+    size_t stride = 0;
+    size_t pixelSize = 0;
+    if (level == GrLevel::Bitmap && parseBitmapLayout(data.data(), size, stride, pixelSize)) {
+        encodeBitmap(history.data(), end, stride, pixelSize, maxChainDepth, writer);
+    } else if (level == GrLevel::Original) {
+        encodeOriginal(history.data(), end, writer);
+    } else if (level == GrLevel::Optimal) {
+        encodeOptimal(history.data(), end, chunkCount, matchFinder, writer);
+    } else {
+        encodeGreedy(history.data(), end, maxChainDepth, chunkCount, writer);
+    }
+
+    result.resize(writer.size());
+
+    lastStats.outputSize = result.size();
+    lastStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+std::vector<uint8_t> GrLzss::decode(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> result;
+
+    // 如果输入数据为空，直接返回空结果
+    if (data.empty()) {
+        return result;
+    }
+
+    // 先求出准确的输出大小，一次分配后直接解压到结果中
+    result.resize(getDecodedSize(data.data(), data.size()));
+    decodeInto(data.data(), data.size(), result.data(), result.size());
+    return result;
+}
+
+namespace {
+
+// 一组（标记字节 + 8个项目）最多占用的输入字节数
+constexpr size_t GROUP_MAX_SIZE = 1 + 8 * 2;
+
+// 加密部分每次解密到栈上缓冲区的字节数
+constexpr size_t DECRYPT_CHUNK = 4096;
+
+/**
+ * @brief 从src[srcPos]起逐组解压到dst[outPos]
+ *
+ * 组的起点到达srcStop、输入用完或输出写满时停止，srcPos和outPos更新为停止时的位置。
+ */
+void decodeGroups(const uint8_t* src, size_t srcSize, size_t srcStop, size_t& srcPosRef,
+                  uint8_t* dst, size_t dstSize, size_t& outPosRef) {
+    // 位置放在局部变量中，写入dst时编译器不必假设它们被改写
+    size_t srcPos = srcPosRef;
+    size_t outPos = outPosRef;
+
+    while (srcPos < srcStop && srcPos < srcSize && outPos < dstSize) {
+        // 读取标记字节
+        uint8_t flags = src[srcPos++];
+
+        // 整组都是原始字节时直接整块复制
+        if (flags == 0xFF && srcSize - srcPos >= 8 && dstSize - outPos >= 8) {
+            std::memcpy(dst + outPos, src + srcPos, 8);
+            srcPos += 8;
+            outPos += 8;
+            continue;
+        }
+
+        for (int i = 0; i < 8 && outPos < dstSize; ++i) {
+            if (flags & (1 << i)) {
+                // 原始数据
+                if (srcPos >= srcSize) {
+                    break;
+                }
+                dst[outPos++] = src[srcPos++];
+            } else {
+                // 压缩数据
+                if (srcPos + 1 >= srcSize) {
+                    break;  // 数据不足
+                }
+                uint8_t lo = src[srcPos++];
+                uint8_t hi = src[srcPos++];
+                size_t offset = (static_cast<size_t>(hi & 0xF0) << 4) | lo;
+                size_t count = std::min(static_cast<size_t>(hi & 0x0F) + GrLzss::MIN_MATCH, dstSize - outPos);
+
+                // 帧偏移换算为向前的距离，距离0表示4KB之前写入的字节
+                size_t distance = (GrLzss::FRAME_INIT_POS + outPos - offset) & GrLzss::FRAME_MASK;
+                if (distance == 0) {
+                    distance = GrLzss::FRAME_SIZE;
+                }
+
+                uint8_t* out = dst + outPos;
+                if (distance > outPos) {
+                    // 引用了初始帧，输出开始之前的部分都是0
+                    for (size_t j = 0; j < count; ++j) {
+                        out[j] = (outPos + j >= distance) ? dst[outPos + j - distance] : 0;
+                    }
+                } else if (distance >= GrLzss::MAX_MATCH && dstSize - outPos >= GrLzss::MAX_MATCH) {
+                    // 不重叠且空间足够，按固定的最大长度整块复制，多出的部分会被后续数据覆盖
+                    std::memcpy(out, out - distance, GrLzss::MAX_MATCH);
+                } else if (distance >= count) {
+                    // 不重叠，整块复制
+                    std::memcpy(out, out - distance, count);
+                } else {
+                    // 与当前位置重叠，逐字节复制
+                    const uint8_t* from = out - distance;
+                    for (size_t j = 0; j < count; ++j) {
+                        out[j] = from[j];
+                    }
+                }
+                outPos += count;
+            }
+        }
+    }
+
+    srcPosRef = srcPos;
+    outPosRef = outPos;
+}
+
+/**
+ * @brief 从src[srcPos]起逐组累计解压后的大小，组的起点到达srcStop或输入用完时停止
+ */
+void scanGroups(const uint8_t* src, size_t srcSize, size_t srcStop, size_t& srcPos, size_t& size) {
+    while (srcPos < srcStop && srcPos < srcSize) {
+        uint8_t flags = src[srcPos++];
+
+        for (int i = 0; i < 8; ++i) {
+            if (flags & (1 << i)) {
+                if (srcPos >= srcSize) {
+                    break;
+                }
+                srcPos += 1;
+                size += 1;
+            } else {
+                if (srcPos + 1 >= srcSize) {
+                    break;
+                }
+                size += (src[srcPos + 1] & 0x0F) + GrLzss::MIN_MATCH;
+                srcPos += 2;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 逐块处理开头被加密的输入
+ *
+ * 每次把从srcPos起的一块（外加一组的余量）复制到栈上的缓冲区，其中加密的字节与密钥流异或，
+ * 再交给process处理起点在这一块内的组。源数据不被修改；加密部分之后的输入由调用者直接处理。
+ * process(buffer, bufferSize, stop, pos) 从buffer[pos]处理到组起点到达stop，返回是否继续。
+ */
+template <class Process>
+void forEachDecryptedChunk(const uint8_t* src, size_t srcSize, const uint8_t* keystream, size_t keySize,
+                           size_t& srcPos, Process process) {
+    uint8_t buffer[DECRYPT_CHUNK + GROUP_MAX_SIZE];
+    keySize = std::min(keySize, srcSize);
+
+    while (srcPos < keySize) {
+        const size_t stop = std::min(keySize, srcPos + DECRYPT_CHUNK);
+        const size_t end = std::min(srcSize, stop + GROUP_MAX_SIZE);
+        const size_t encryptedEnd = std::min(end, keySize);
+
+        std::memcpy(buffer, src + srcPos, end - srcPos);
+        for (size_t i = 0; i < encryptedEnd - srcPos; ++i) {
+            buffer[i] ^= keystream[srcPos + i];
+        }
+
+        size_t pos = 0;
+        const bool more = process(buffer, end - srcPos, stop - srcPos, pos);
+        srcPos += pos;
+        if (!more || pos == 0) {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+size_t GrLzss::decodeInto(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    size_t srcPos = 0;
+    size_t outPos = 0;
+    decodeGroups(src, srcSize, srcSize, srcPos, dst, dstSize, outPos);
+    return outPos;
+}
+
+size_t GrLzss::decodeInto(const uint8_t* src, size_t srcSize, const uint8_t* keystream, size_t keySize,
+                          uint8_t* dst, size_t dstSize) {
+    size_t srcPos = 0;
+    size_t outPos = 0;
+
+    // 加密部分逐块解密后解压
+    forEachDecryptedChunk(src, srcSize, keystream, keySize, srcPos,
+        [&](const uint8_t* buffer, size_t bufferSize, size_t stop, size_t& pos) {
+            decodeGroups(buffer, bufferSize, stop, pos, dst, dstSize, outPos);
+            return outPos < dstSize;
+        });
+
+    // 其余部分直接从源数据解压
+    decodeGroups(src, srcSize, srcSize, srcPos, dst, dstSize, outPos);
+    return outPos;
+}
+
+size_t GrLzss::getDecodedSize(const uint8_t* src, size_t srcSize) {
+    size_t srcPos = 0;
+    size_t size = 0;
+    scanGroups(src, srcSize, srcSize, srcPos, size);
+    return size;
+}
+
+size_t GrLzss::getDecodedSize(const uint8_t* src, size_t srcSize, const uint8_t* keystream, size_t keySize) {
+    size_t srcPos = 0;
+    size_t size = 0;
+
+    forEachDecryptedChunk(src, srcSize, keystream, keySize, srcPos,
+        [&](const uint8_t* buffer, size_t bufferSize, size_t stop, size_t& pos) {
+            scanGroups(buffer, bufferSize, stop, pos, size);
+            return true;
+        });
+
+    scanGroups(src, srcSize, srcSize, srcPos, size);
+    return size;
+}
+
+size_t GrLzss::encodeFile(const std::string& inputFilename, const std::string& outputFilename) {
+    // 读取输入文件
+    std::ifstream inFile(inputFilename, std::ios::binary);
+    if (!inFile) {
+        std::cerr << "Error: Cannot open input file: " << inputFilename << std::endl;
+        return 0;
+    }
+
+    // 读取文件内容
+    std::vector<uint8_t> inputData((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    inFile.close();
+
+    // 压缩数据
+    std::vector<uint8_t> outputData = encode(inputData);
+
+    // 写入输出文件
+    std::ofstream outFile(outputFilename, std::ios::binary);
+    if (!outFile) {
+        std::cerr << "Error: Cannot open output file: " << outputFilename << std::endl;
+        return 0;
+    }
+
+    outFile.write(reinterpret_cast<const char*>(outputData.data()), outputData.size());
+    outFile.close();
+
+    return outputData.size();
+}
+
+size_t GrLzss::decodeFile(const std::string& inputFilename, const std::string& outputFilename) {
+    // 打开输入文件
+    std::ifstream inFile(inputFilename, std::ios::binary);
+    if (!inFile) {
+        std::cerr << "Error: Cannot open input file: " << inputFilename << std::endl;
+        return 0;
+    }
+
+    // 打开输出文件
+    std::ofstream outFile(outputFilename, std::ios::binary);
+    if (!outFile) {
+        std::cerr << "Error: Cannot open output file: " << outputFilename << std::endl;
+        return 0;
+    }
+
+    // 分块读取、增量解压并写出，不在内存中保存完整的输入或输出
+    constexpr size_t BUFFER_SIZE = 64 * 1024;
+    std::vector<uint8_t> inBuf(BUFFER_SIZE);
+    std::vector<uint8_t> outBuf(BUFFER_SIZE);
+    GrStreamDecoder decoder;
+    size_t total = 0;
+
+    while (inFile) {
+        inFile.read(reinterpret_cast<char*>(inBuf.data()), inBuf.size());
+        size_t got = static_cast<size_t>(inFile.gcount());
+        if (got == 0) {
+            break;
+        }
+
+        size_t pos = 0;
+        while (true) {
+            size_t consumed = 0;
+            size_t produced = decoder.decode(inBuf.data() + pos, got - pos, outBuf.data(), outBuf.size(), consumed);
+            pos += consumed;
+            outFile.write(reinterpret_cast<const char*>(outBuf.data()), produced);
+            total += produced;
+
+            if (pos == got && produced < outBuf.size()) {
+                break;
+            }
+        }
+    }
+    outFile.close();
+
+    return total;
+}
+
+GrStreamDecoder::GrStreamDecoder() {
+    reset();
+}
+
+void GrStreamDecoder::reset() {
+    std::memset(m_frame, 0, sizeof(m_frame));
+    m_framePos = GrLzss::FRAME_INIT_POS;
+    m_flags = 0;
+    m_itemIndex = 8;
+    m_lo = 0;
+    m_haveLo = false;
+    m_matchOffset = 0;
+    m_matchRemaining = 0;
+}
+
+size_t GrStreamDecoder::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize, size_t& consumed) {
+    size_t srcPos = 0;
+    size_t outPos = 0;
+
+    while (outPos < dstSize) {
+        // 先输出上次未输出完的匹配
+        if (m_matchRemaining > 0) {
+            size_t count = std::min(m_matchRemaining, dstSize - outPos);
+            for (size_t j = 0; j < count; ++j) {
+                uint8_t byte = m_frame[m_matchOffset];
+                m_matchOffset = (m_matchOffset + 1) & GrLzss::FRAME_MASK;
+                m_frame[m_framePos] = byte;
+                m_framePos = (m_framePos + 1) & GrLzss::FRAME_MASK;
+                dst[outPos++] = byte;
+            }
+            m_matchRemaining -= count;
+            continue;
+        }
+
+        // 读取新的标记字节
+        if (m_itemIndex >= 8) {
+            if (srcPos >= srcSize) {
+                break;
+            }
+            m_flags = src[srcPos++];
+            m_itemIndex = 0;
+        }
+
+        if (m_flags & (1 << m_itemIndex)) {
+            // 原始数据
+            if (srcPos >= srcSize) {
+                break;
+            }
+            uint8_t byte = src[srcPos++];
+            m_frame[m_framePos] = byte;
+            m_framePos = (m_framePos + 1) & GrLzss::FRAME_MASK;
+            dst[outPos++] = byte;
+        } else {
+            // 压缩数据，两个字节可能分在两次调用中
+            if (!m_haveLo) {
+                if (srcPos >= srcSize) {
+                    break;
+                }
+                m_lo = src[srcPos++];
+                m_haveLo = true;
+            }
+            if (srcPos >= srcSize) {
+                break;
+            }
+            uint8_t hi = src[srcPos++];
+            m_haveLo = false;
+            m_matchOffset = (static_cast<size_t>(hi & 0xF0) << 4) | m_lo;
+            m_matchRemaining = (hi & 0x0F) + GrLzss::MIN_MATCH;
+        }
+        ++m_itemIndex;
+    }
+
+    consumed = srcPos;
+    return outPos;
+}
+
+} // namespace compression
+} // namespace eagls
@@ -0,0 +1,237 @@
+﻿#include "gr_window_search.h"
+#include "core/compression/gr_lzss.h"
+#include <algorithm>
+
+#ifdef EAGLS_GR_WINDOW_SEARCH_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// 只为单个函数开启SSE2/AVX2，整个项目仍按基础指令集编译
+#if defined(__GNUC__) || defined(__clang__)
+    #define EAGLS_TARGET_SSE2 __attribute__((target("sse2")))
+    #define EAGLS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define EAGLS_TARGET_SSE2
+    #define EAGLS_TARGET_AVX2
+#endif
+
+namespace eagls {
+namespace compression {
+namespace detail {
+
+namespace {
+
+// 匹配至少要达到的长度减1，作为搜索的起点
+constexpr size_t INITIAL_BEST = GrLzss::MIN_MATCH - 1;
+
+inline int highestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+} // namespace
+
+size_t searchWindowScalar(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos, size_t knownLength) {
+    if (maxLength < GrLzss::MIN_MATCH || knownLength >= maxLength) {
+        return knownLength >= GrLzss::MIN_MATCH ? knownLength : 0;
+    }
+
+    const uint8_t* cur = history + pos;
+    size_t best = std::max(INITIAL_BEST, knownLength);
+
+    // 从最近的位置向前，长度相同时保留最近的
+    for (size_t cand = pos; cand-- > pos - GrLzss::FRAME_SIZE;) {
+        const uint8_t* ref = history + cand;
+        if (ref[best] != cur[best] || ref[0] != cur[0]) {
+            continue;
+        }
+        size_t len = 1;
+        while (len < maxLength && ref[len] == cur[len]) {
+            ++len;
+        }
+        if (len > best) {
+            best = len;
+            matchPos = cand;
+            if (len == maxLength) {
+                break;
+            }
+        }
+    }
+
+    return best >= GrLzss::MIN_MATCH ? best : 0;
+}
+
+#ifdef EAGLS_GR_WINDOW_SEARCH_X86
+
+/*
+ * 向量实现：一次检查一个块中的16/32个候选起点。
+ * 先用第0个字节和第best个字节筛掉不可能更长的候选，
+ * 再逐字节比较，直到块内所有候选都不再匹配。
+ */
+
+EAGLS_TARGET_SSE2
+size_t searchWindowSse2(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos, size_t knownLength) {
+    constexpr size_t LANES = 16;
+    if (maxLength < GrLzss::MIN_MATCH || knownLength >= maxLength) {
+        return knownLength >= GrLzss::MIN_MATCH ? knownLength : 0;
+    }
+
+    const uint8_t* cur = history + pos;
+    __m128i needle[GrLzss::MAX_MATCH];
+    for (size_t k = 0; k < maxLength; ++k) {
+        needle[k] = _mm_set1_epi8(static_cast<char>(cur[k]));
+    }
+
+    size_t best = std::max(INITIAL_BEST, knownLength);
+    for (size_t base = pos - LANES; ; base -= LANES) {
+        const uint8_t* block = history + base;
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), needle[0]),
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + best)), needle[best]))));
+
+        if (mask != 0) {
+            size_t len = 1;
+            for (; len < maxLength; ++len) {
+                uint32_t next = mask & static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + len)), needle[len])));
+                if (next == 0) {
+                    break;
+                }
+                mask = next;
+            }
+            if (len > best) {
+                best = len;
+                matchPos = base + highestBit(mask);
+                if (len == maxLength) {
+                    break;
+                }
+            }
+        }
+
+        if (base == pos - GrLzss::FRAME_SIZE) {
+            break;
+        }
+    }
+
+    return best >= GrLzss::MIN_MATCH ? best : 0;
+}
+
+EAGLS_TARGET_AVX2
+size_t searchWindowAvx2(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos, size_t knownLength) {
+    constexpr size_t LANES = 32;
+    if (maxLength < GrLzss::MIN_MATCH || knownLength >= maxLength) {
+        return knownLength >= GrLzss::MIN_MATCH ? knownLength : 0;
+    }
+
+    const uint8_t* cur = history + pos;
+    __m256i needle[GrLzss::MAX_MATCH];
+    for (size_t k = 0; k < maxLength; ++k) {
+        needle[k] = _mm256_set1_epi8(static_cast<char>(cur[k]));
+    }
+
+    size_t best = std::max(INITIAL_BEST, knownLength);
+    for (size_t base = pos - LANES; ; base -= LANES) {
+        const uint8_t* block = history + base;
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), needle[0]),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + best)), needle[best]))));
+
+        if (mask != 0) {
+            size_t len = 1;
+            for (; len < maxLength; ++len) {
+                uint32_t next = mask & static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + len)), needle[len])));
+                if (next == 0) {
+                    break;
+                }
+                mask = next;
+            }
+            if (len > best) {
+                best = len;
+                matchPos = base + highestBit(mask);
+                if (len == maxLength) {
+                    break;
+                }
+            }
+        }
+
+        if (base == pos - GrLzss::FRAME_SIZE) {
+            break;
+        }
+    }
+
+    return best >= GrLzss::MIN_MATCH ? best : 0;
+}
+
+namespace {
+
+bool cpuSupportsSse2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpuSupportsAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // 需要操作系统保存YMM寄存器状态
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+#endif // EAGLS_GR_WINDOW_SEARCH_X86
+
+WindowSearchFn selectWindowSearch(const char** name) {
+    WindowSearchFn fn = searchWindowScalar;
+    const char* selected = "scalar";
+#ifdef EAGLS_GR_WINDOW_SEARCH_X86
+    if (cpuSupportsSse2()) {
+        fn = searchWindowSse2;
+        selected = "sse2";
+    }
+    if (cpuSupportsAvx2()) {
+        fn = searchWindowAvx2;
+        selected = "avx2";
+    }
+#endif
+    if (name) {
+        *name = selected;
+    }
+    return fn;
+}
+
+} // namespace detail
+} // namespace compression
+} // namespace eagls
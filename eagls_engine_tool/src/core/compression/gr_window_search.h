@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define EAGLS_GR_WINDOW_SEARCH_X86
+#endif
+
+namespace eagls {
+namespace compression {
+namespace detail {
+
+/**
+ * @brief 在4KB窗口内逐个位置比较，查找最长匹配（GrLzss内部使用）
+ *
+ * 工作在"4KB全0前导 + 输入数据"组成的历史缓冲区上，候选起点为 [pos - 4096, pos)，
+ * 包括哈希链不会插入的初始全0帧，因此结果一定是窗口内的最长匹配；
+ * 长度相同时取最近的位置。
+ * 向量实现会多读候选块末尾之后的字节，历史缓冲区在数据之后至少要有WINDOW_SEARCH_PADDING字节可读。
+ * @param history 历史缓冲区
+ * @param pos 当前位置（不小于4096）
+ * @param maxLength 允许的最大匹配长度
+ * @param matchPos 输出匹配位置
+ * @param knownLength 调用者已有的匹配长度，只查找比它更长的匹配，找不到时返回它且不修改matchPos
+ * @return 最长匹配长度，不足3时返回0
+ */
+using WindowSearchFn = size_t (*)(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos,
+                                  size_t knownLength);
+
+constexpr size_t WINDOW_SEARCH_PADDING = 64;
+
+size_t searchWindowScalar(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos, size_t knownLength);
+
+#ifdef EAGLS_GR_WINDOW_SEARCH_X86
+size_t searchWindowSse2(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos, size_t knownLength);
+size_t searchWindowAvx2(const uint8_t* history, size_t pos, size_t maxLength, size_t& matchPos, size_t knownLength);
+#endif
+
+/**
+ * @brief 按运行时CPU支持的指令集选择实现（AVX2 > SSE2 > 标量）
+ * @param name 输出所选实现的名称，可为nullptr
+ * @return 查找函数
+ */
+WindowSearchFn selectWindowSearch(const char** name = nullptr);
+
+} // namespace detail
+} // namespace compression
+} // namespace eagls
@@ -7,10 +7,30 @@
 namespace eagls {
 namespace compression {
 
-LZSS::LZSS(int preBufSizeBits) 
+namespace {
+
+// 哈希链匹配查找器参数
+constexpr int HASH_BITS = 15;                  // 3字节前缀哈希表位数
+constexpr uint32_t HASH_SIZE = 1u << HASH_BITS;
+constexpr uint32_t PAIR_SIZE = 1u << 16;       // 2字节前缀直接索引
+constexpr int32_t NIL = -1;                    // 空链接
+
+inline uint32_t hash3(const uint8_t* p) {
+    uint32_t v = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+inline uint32_t hash2(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 8) | p[1];
+}
+
+} // namespace
+
+LZSS::LZSS(int preBufSizeBits, int maxChainDepth) 
     : threshold(2), 
       preBufSizeBits(preBufSizeBits),
-      windowBufSizeBits(16 - preBufSizeBits) {
+      windowBufSizeBits(16 - preBufSizeBits),
+      maxChainDepth(maxChainDepth > 0 ? maxChainDepth : 1) {
     
     // 通过占用的比特位计算缓冲区大小 2^(preBufSizeBits) - 1 + 2
     preBufSize = (1 << preBufSizeBits) - 1 + threshold;
@@ -27,101 +47,129 @@ std::vector<uint8_t> LZSS::encode(const std::vector<uint8_t>& data) {
         return result;
     }
     
-    std::vector<uint8_t> windowBuf;  // 滑动窗口
-    std::vector<uint8_t> preBuf;     // 前向缓冲区
+    const uint8_t* src = data.data();
+    const size_t size = data.size();
+    const size_t windowSize = static_cast<size_t>(windowBufSize);
+    const size_t maxMatch = static_cast<size_t>(preBufSize);
+    const size_t minMatch = static_cast<size_t>(threshold);
     
-    // 初始化前向缓冲区
-    size_t dataPos = 0;
-    while (preBuf.size() < preBufSize && dataPos < data.size()) {
-        preBuf.push_back(data[dataPos++]);
+    // 链接数组是覆盖整个滑动窗口的固定环形缓冲区，按 位置 & ringMask 寻址
+    size_t ringSize = 1;
+    while (ringSize <= windowSize) {
+        ringSize <<= 1;
     }
+    const size_t ringMask = ringSize - 1;
+    
+    // 3字节前缀哈希链，以及用于补充长度为2的匹配的2字节前缀链
+    std::vector<int32_t> head3(HASH_SIZE, NIL);
+    std::vector<int32_t> prev3(ringSize, NIL);
+    std::vector<int32_t> head2(PAIR_SIZE, NIL);
+    std::vector<int32_t> prev2(ringSize, NIL);
     
-    uint8_t signbits = 0;    // 标记字节
-    int itemnum = 0;         // 项目计数
-    std::vector<uint8_t> restorebuff;  // 临时缓冲区
+    auto insert = [&](size_t pos) {
+        if (pos + 1 >= size) {
+            return;
+        }
+        uint32_t h2 = hash2(src + pos);
+        prev2[pos & ringMask] = head2[h2];
+        head2[h2] = static_cast<int32_t>(pos);
+        
+        if (pos + 2 >= size) {
+            return;
+        }
+        uint32_t h3 = hash3(src + pos);
+        prev3[pos & ringMask] = head3[h3];
+        head3[h3] = static_cast<int32_t>(pos);
+    };
+    
+    // 最坏情况：全部为原始数据，每8个项目多一个标记字节
+    result.reserve(size + size / 8 + 1);
+    
+    size_t flagPos = 0;  // 当前组标记字节的位置
+    int itemnum = 0;     // 项目计数
+    size_t pos = 0;
     
-    // 前向缓冲区有数据时继续压缩
-    while (!preBuf.empty()) {
-        // 在滑动窗口中寻找最长匹配串
-        size_t matchIndex = 0;
+    while (pos < size) {
+        // 每组开始时预留标记字节
+        if (itemnum == 0) {
+            flagPos = result.size();
+            result.push_back(0);
+        }
+        
+        // 滑动窗口为 [windowStart, pos)，匹配串不能越过当前位置
+        const size_t windowStart = pos > windowSize ? pos - windowSize : 0;
+        const size_t maxLength = std::min(maxMatch, size - pos);
+        size_t matchPos = 0;
         size_t matchLength = 0;
         
-        // 从最小匹配长度开始查找
-        for (size_t i = threshold; i <= preBuf.size(); ++i) {
-            // 在滑动窗口中查找匹配
-            bool found = false;
-            for (size_t j = 0; j + i <= windowBuf.size(); ++j) {
-                if (std::equal(preBuf.begin(), preBuf.begin() + i, windowBuf.begin() + j)) {
-                    matchIndex = j;
-                    matchLength = i;
-                    found = true;
+        // 沿3字节哈希链由近及远查找最长匹配
+        if (maxLength >= 3) {
+            int32_t cand = head3[hash3(src + pos)];
+            for (int depth = 0; depth < maxChainDepth && cand != NIL; ++depth) {
+                size_t candPos = static_cast<size_t>(cand);
+                if (candPos < windowStart) {
                     break;
                 }
+                
+                size_t limit = std::min(maxLength, pos - candPos);
+                if (limit > matchLength && src[candPos + matchLength] == src[pos + matchLength]) {
+                    size_t len = 0;
+                    while (len < limit && src[candPos + len] == src[pos + len]) {
+                        ++len;
+                    }
+                    if (len > matchLength) {
+                        matchLength = len;
+                        matchPos = candPos;
+                        if (len == maxLength) {
+                            break;
+                        }
+                    }
+                }
+                
+                cand = prev3[candPos & ringMask];
             }
-            
-            // 如果没找到更长的匹配，就退出循环
-            if (!found) {
-                break;
+        }
+        
+        // 没有找到3字节以上的匹配时，尝试长度为2的匹配
+        if (matchLength < minMatch && maxLength >= minMatch) {
+            int32_t cand = head2[hash2(src + pos)];
+            while (cand != NIL && static_cast<size_t>(cand) + minMatch > pos) {
+                cand = prev2[static_cast<size_t>(cand) & ringMask];
+            }
+            if (cand != NIL && static_cast<size_t>(cand) >= windowStart) {
+                matchLength = minMatch;
+                matchPos = static_cast<size_t>(cand);
             }
         }
         
-        // 如果找到了足够长的匹配串
-        if (matchLength >= threshold) {
-            // 计算编码值
-            uint16_t code = static_cast<uint16_t>((matchIndex << preBufSizeBits) | (matchLength - threshold));
-            
-            // 添加到临时缓冲区
-            restorebuff.push_back(code & 0xFF);
-            restorebuff.push_back((code >> 8) & 0xFF);
+        if (matchLength >= minMatch) {
+            // 计算编码值，匹配位置为滑动窗口内的下标
+            uint16_t code = static_cast<uint16_t>(((matchPos - windowStart) << preBufSizeBits) | (matchLength - minMatch));
+            result.push_back(code & 0xFF);
+            result.push_back((code >> 8) & 0xFF);
             
             // 不设置标志位，表示这是压缩数据
         } else {
             // 没有找到匹配，直接输出原始数据
             matchLength = 1;
-            restorebuff.push_back(preBuf[0]);
+            result.push_back(src[pos]);
             
             // 设置标志位，表示这是原始数据
-            signbits |= (1 << (7 - itemnum));
-        }
-        
-        // 项目计数增加
-        itemnum++;
-        
-        // 如果已经处理了8个项目，写入一组数据
-        if (itemnum >= 8) {
-            result.push_back(signbits);
-            result.insert(result.end(), restorebuff.begin(), restorebuff.end());
-            
-            // 重置计数和缓冲区
-            itemnum = 0;
-            signbits = 0;
-            restorebuff.clear();
+            result[flagPos] |= static_cast<uint8_t>(1 << (7 - itemnum));
         }
         
-        // 更新滑动窗口和前向缓冲区
-        // 将匹配的数据移入滑动窗口
-        windowBuf.insert(windowBuf.end(), preBuf.begin(), preBuf.begin() + matchLength);
-        
-        // 如果滑动窗口超出大小限制，移除前面的数据
-        if (windowBuf.size() > windowBufSize) {
-            windowBuf.erase(windowBuf.begin(), windowBuf.begin() + (windowBuf.size() - windowBufSize));
+        // 将已处理的位置加入哈希链
+        for (size_t i = 0; i < matchLength; ++i) {
+            insert(pos + i);
         }
+        pos += matchLength;
         
-        // 从前向缓冲区移除已处理的数据
-        preBuf.erase(preBuf.begin(), preBuf.begin() + matchLength);
-        
-        // 从输入数据中读取新数据填充前向缓冲区
-        while (preBuf.size() < preBufSize && dataPos < data.size()) {
-            preBuf.push_back(data[dataPos++]);
+        // 处理了8个项目后开始新的一组
+        if (++itemnum >= 8) {
+            itemnum = 0;
         }
     }
     
-    // 处理最后不足8个项目的数据
-    if (itemnum > 0) {
-        result.push_back(signbits);
-        result.insert(result.end(), restorebuff.begin(), restorebuff.end());
-    }
-    
     return result;
 }
 
@@ -133,7 +181,9 @@ std::vector<uint8_t> LZSS::decode(const std::vector<uint8_t>& data) {
         return result;
     }
     
-    std::vector<uint8_t> windowBuf;  // 滑动窗口
+    // 滑动窗口就是输出的最后windowBufSize个字节，不再单独维护
+    const size_t windowSize = static_cast<size_t>(windowBufSize);
+    result.reserve(data.size() * 2);
     
     size_t dataPos = 0;
     
@@ -147,9 +197,7 @@ std::vector<uint8_t> LZSS::decode(const std::vector<uint8_t>& data) {
             // 检查标记位
             if (signbits & (1 << (7 - i))) {
                 // 原始数据
-                uint8_t byte = data[dataPos++];
-                result.push_back(byte);
-                windowBuf.push_back(byte);
+                result.push_back(data[dataPos++]);
             } else {
                 // 压缩数据
                 if (dataPos + 1 >= data.size()) {
@@ -165,23 +213,20 @@ std::vector<uint8_t> LZSS::decode(const std::vector<uint8_t>& data) {
                 uint16_t length = (code & ((1 << preBufSizeBits) - 1)) + threshold;
                 
                 // 检查偏移是否有效
-                if (offset >= windowBuf.size()) {
+                const size_t windowStart = result.size() > windowSize ? result.size() - windowSize : 0;
+                if (offset >= result.size() - windowStart) {
                     // 无效偏移，可能是数据损坏
                     continue;
                 }
                 
-                // 复制匹配的数据
+                // 复制匹配的数据，源可能与新写入的数据重叠，逐字节复制
+                size_t from = windowStart + offset;
+                size_t to = result.size();
+                result.resize(to + length);
                 for (uint16_t j = 0; j < length; ++j) {
-                    uint8_t byte = windowBuf[offset + j];
-                    result.push_back(byte);
-                    windowBuf.push_back(byte);
+                    result[to + j] = result[from + j];
                 }
             }
-            
-            // 限制滑动窗口大小
-            if (windowBuf.size() > windowBufSize) {
-                windowBuf.erase(windowBuf.begin(), windowBuf.begin() + (windowBuf.size() - windowBufSize));
-            }
         }
     }
     
@@ -1,11 +1,205 @@
 ﻿#include "core/encryption/eagls_encryption.h"
+#include "core/encryption/xor_kernels.h"
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace eagls {
 namespace encryption {
 
-EaglsEncryption::EaglsEncryption() : m_key("EAGLS_SYSTEM") {
+namespace {
+
+// 索引种子是32位的，最多保留这么多个种子的密钥流
+constexpr size_t MAX_INDEX_SEEDS = 8;
+
+// 每种加密的缓存最多保留的密钥流字节数
+constexpr size_t MAX_CACHE_BYTES = 64 * 1024 * 1024;
+
+// 分给多个线程生成时，每个线程至少生成的字节数
+constexpr size_t PARALLEL_CHUNK = 64 * 1024;
+
+/**
+ * @brief 生成密钥流中 [first, first + count) 这一段
+ *
+ * 生成器能跳跃时（C运行时生成器），较长的一段平均分给多个线程生成；
+ * Lehmer生成器不能跳跃，只用于开头的0x174b字节，直接生成。
+ */
+template <class Cipher>
+void generateKeystream(uint32_t seed, size_t first, uint8_t* out, size_t count) {
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t threadCount = std::min(hardwareThreads, count / PARALLEL_CHUNK);
+    if (!Cipher::CAN_SPLIT || threadCount <= 1) {
+        Cipher::keystream(seed, first, out, count);
+        return;
+    }
+
+    const size_t chunk = (count + threadCount - 1) / threadCount;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; ++t) {
+        const size_t begin = t * chunk;
+        const size_t end = std::min(count, begin + chunk);
+        workers.emplace_back([=]() { Cipher::keystream(seed, first + begin, out + begin, end - begin); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+using GenerateFn = void (*)(uint32_t seed, size_t first, uint8_t* out, size_t count);
+
+/**
+ * @brief 一种加密的密钥流缓存
+ *
+ * 每个种子保存已生成的密钥流，需要更长时只生成新增的部分。
+ * 种子数或总字节数超出上限时淘汰最久未使用的密钥流。
+ * 生成在锁外进行，发布前重新检查，其他线程已发布更长的密钥流时直接使用它。
+ */
+class SeedCache {
+public:
+    SeedCache(size_t maxSeeds, size_t maxBytes, GenerateFn generate)
+        : m_maxSeeds(maxSeeds), m_maxBytes(maxBytes), m_totalBytes(0), m_clock(0), m_generate(generate) {}
+
+    KeystreamCache::Keystream get(uint32_t seed, size_t length) {
+        KeystreamCache::Keystream stream;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_streams.find(seed);
+            if (it != m_streams.end()) {
+                it->second.lastUse = ++m_clock;
+                stream = it->second.stream;
+                if (stream->size() >= length) {
+                    return stream;
+                }
+            }
+        }
+
+        // 至少翻倍（不超过字节上限），避免逐渐变长的请求反复重建
+        const size_t current = stream ? stream->size() : 0;
+        const size_t target = std::max(length, std::min(current * 2, m_maxBytes));
+        auto grown = std::make_shared<std::vector<uint8_t>>(target);
+        if (stream) {
+            std::copy(stream->begin(), stream->end(), grown->begin());
+        }
+        m_generate(seed, current, grown->data() + current, target - current);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_streams.find(seed);
+        if (it != m_streams.end()) {
+            if (it->second.stream->size() >= target) {
+                it->second.lastUse = ++m_clock;
+                return it->second.stream;
+            }
+            m_totalBytes -= it->second.stream->size();
+            it->second.stream = grown;
+        } else {
+            it = m_streams.emplace(seed, Entry{ grown, 0 }).first;
+        }
+        it->second.lastUse = ++m_clock;
+        m_totalBytes += target;
+        evict(seed);
+        return grown;
+    }
+
+private:
+    struct Entry {
+        KeystreamCache::Keystream stream;  // 密钥流
+        uint64_t lastUse;                  // 最近一次使用的时钟
+    };
+
+    /**
+     * @brief 淘汰最久未使用的密钥流，直到不超出上限
+     * @param keep 刚发布的种子，最后才淘汰
+     */
+    void evict(uint32_t keep) {
+        while (m_streams.size() > m_maxSeeds || (m_totalBytes > m_maxBytes && m_streams.size() > 1)) {
+            auto oldest = m_streams.end();
+            for (auto it = m_streams.begin(); it != m_streams.end(); ++it) {
+                if (it->first != keep && (oldest == m_streams.end() || it->second.lastUse < oldest->second.lastUse)) {
+                    oldest = it;
+                }
+            }
+            m_totalBytes -= oldest->second.stream->size();
+            m_streams.erase(oldest);
+        }
+        // 单个密钥流就超出上限时不保留，调用者持有的仍然有效
+        if (m_totalBytes > m_maxBytes) {
+            m_streams.clear();
+            m_totalBytes = 0;
+        }
+    }
+
+    std::mutex m_mutex;
+    std::unordered_map<uint32_t, Entry> m_streams;
+    size_t m_maxSeeds;
+    size_t m_maxBytes;
+    size_t m_totalBytes;
+    uint64_t m_clock;
+    GenerateFn m_generate;
+};
+
+/*
+ * 与内置实现不一致的密钥配置使用运行时参数的加密，不经过密钥流缓存。
+ */
+
+cipher::RuntimeCipher<cipher::LehmerRng> makeGrCipher(const KeyProfile& profile) {
+    cipher::RuntimeCipher<cipher::LehmerRng> result;
+    result.key = profile.eaglsKey.c_str();
+    result.keyLength = profile.eaglsKey.size();
+    result.limit = profile.lehmerLimit;
+    return result;
+}
+
+cipher::RuntimeCipher<cipher::CRuntimeRng> makeDatCipher(const KeyProfile& profile) {
+    cipher::RuntimeCipher<cipher::CRuntimeRng> result;
+    result.key = profile.eaglsKey.c_str();
+    result.keyLength = profile.eaglsKey.size();
+    result.offset = profile.datTextOffset;
+    result.stride = 2;
+    return result;
+}
+
+cipher::RuntimeCipher<cipher::CRuntimeRng> makeIndexCipher(const KeyProfile& profile) {
+    cipher::RuntimeCipher<cipher::CRuntimeRng> result;
+    result.key = profile.indexKey.c_str();
+    result.keyLength = profile.indexKey.size();
+    return result;
+}
+
+} // namespace
+
+KeystreamCache::Keystream KeystreamCache::getLehmer(uint8_t seed) {
+    static SeedCache cache(256, MAX_CACHE_BYTES, generateKeystream<cipher::GrCipher>);
+    return cache.get(cipher::grSeed(seed), LEHMER_LIMIT);
+}
+
+KeystreamCache::Keystream KeystreamCache::getEagls(uint8_t seed, size_t length) {
+    static SeedCache cache(256, MAX_CACHE_BYTES, generateKeystream<cipher::DatCipher>);
+    return cache.get(cipher::datSeed(seed), length);
+}
+
+KeystreamCache::Keystream KeystreamCache::getIndex(uint32_t seed, size_t length) {
+    static SeedCache cache(MAX_INDEX_SEEDS, MAX_CACHE_BYTES, generateKeystream<cipher::IndexCipher>);
+    return cache.get(seed, length);
+}
+
+void KeystreamCache::generateEagls(uint8_t seed, size_t first, uint8_t* out, size_t count) {
+    generateKeystream<cipher::DatCipher>(cipher::datSeed(seed), first, out, count);
+}
+
+void KeystreamCache::generateIndex(uint32_t seed, size_t first, uint8_t* out, size_t count) {
+    generateKeystream<cipher::IndexCipher>(seed, first, out, count);
+}
+
+EaglsEncryption::EaglsEncryption() : EaglsEncryption(KeyProfileRegistry::getDefault()) {
+}
+
+EaglsEncryption::EaglsEncryption(const KeyProfile& profile)
+    : m_profile(profile), m_builtin(profile.usesBuiltinDatCipher()) {
 }
 
 std::vector<uint8_t> EaglsEncryption::encrypt(const std::vector<uint8_t>& data) {
@@ -14,27 +208,66 @@ std::vector<uint8_t> EaglsEncryption::encrypt(const std::vector<uint8_t>& data)
 }
 
 std::vector<uint8_t> EaglsEncryption::decrypt(const std::vector<uint8_t>& data) {
+    // 复制数据，在副本上解密
+    std::vector<uint8_t> result = data;
+    decryptInPlace(result.data(), result.size());
+    return result;
+}
+
+void EaglsEncryption::encryptInPlace(uint8_t* data, size_t size) {
+    // 加密和解密使用相同的算法
+    decryptInPlace(data, size);
+}
+
+void EaglsEncryption::decryptInPlace(uint8_t* data, size_t size) {
+    // 文本偏移量
+    const size_t text_offset = m_profile.datTextOffset;
+    
     // 如果数据太小，无法解密
-    if (data.size() <= 3602) {
-        return data;
+    if (size <= text_offset + 2) {
+        return;
     }
     
-    // 复制数据，因为我们需要修改它
-    std::vector<uint8_t> result = data;
+    if (!m_builtin) {
+        makeDatCipher(m_profile).apply(data, size - 2, cipher::datSeed(data[size - 1]));
+        return;
+    }
     
-    // 文本偏移量和长度
-    const size_t text_offset = 3600;
-    const size_t text_length = data.size() - text_offset - 2;
+    // 取出该种子的密钥流，每隔一个字节解密
+    const size_t text_length = size - text_offset - 2;
+    const size_t keySize = (text_length + 1) / 2;
+    KeystreamCache::Keystream stream = KeystreamCache::getEagls(data[size - 1], keySize);
+    xorKeystreamStride2(data + text_offset, stream->data(), keySize);
+}
+
+void EaglsEncryption::decryptRange(uint8_t* data, size_t offset, size_t size, size_t fileSize, uint8_t seed) {
+    const size_t text_offset = m_profile.datTextOffset;
+    if (fileSize <= text_offset + 2) {
+        return;
+    }
     
-    // 设置随机数种子
-    m_rng.srand(data.back());
+    // 加密区域为 [text_offset, text_end) 中与text_offset相差偶数的位置
+    const size_t text_end = fileSize - 2;
+    const size_t begin = std::max(offset, text_offset);
+    const size_t end = std::min(offset + size, text_end);
+    if (begin >= end) {
+        return;
+    }
     
-    // 解密文本部分
-    for (size_t i = 0; i < text_length; i += 2) {
-        result[text_offset + i] ^= m_key[m_rng.rand() % m_key.size()];
+    // 这一段对应的密钥流序号 [firstKey, lastKey)
+    const size_t firstKey = (begin - text_offset + 1) / 2;
+    const size_t lastKey = (end - text_offset + 1) / 2;
+    if (firstKey >= lastKey) {
+        return;
     }
     
-    return result;
+    std::vector<uint8_t> keystream(lastKey - firstKey);
+    if (m_builtin) {
+        KeystreamCache::generateEagls(seed, firstKey, keystream.data(), keystream.size());
+    } else {
+        makeDatCipher(m_profile).keystream(cipher::datSeed(seed), firstKey, keystream.data(), keystream.size());
+    }
+    xorKeystreamStride2(data + (text_offset + 2 * firstKey - offset), keystream.data(), keystream.size());
 }
 
 bool EaglsEncryption::encryptFile(const std::string& inputFilename, const std::string& outputFilename) {
@@ -49,8 +282,8 @@ bool EaglsEncryption::encryptFile(const std::string& inputFilename, const std::s
     std::vector<uint8_t> inputData((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
     inFile.close();
     
-    // 加密数据
-    std::vector<uint8_t> outputData = encrypt(inputData);
+    // 原地加密数据
+    encryptInPlace(inputData.data(), inputData.size());
     
     // 写入输出文件
     std::ofstream outFile(outputFilename, std::ios::binary);
@@ -59,7 +292,7 @@ bool EaglsEncryption::encryptFile(const std::string& inputFilename, const std::s
         return false;
     }
     
-    outFile.write(reinterpret_cast<const char*>(outputData.data()), outputData.size());
+    outFile.write(reinterpret_cast<const char*>(inputData.data()), inputData.size());
     outFile.close();
     
     return true;
@@ -77,8 +310,8 @@ bool EaglsEncryption::decryptFile(const std::string& inputFilename, const std::s
     std::vector<uint8_t> inputData((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
     inFile.close();
     
-    // 解密数据
-    std::vector<uint8_t> outputData = decrypt(inputData);
+    // 原地解密数据
+    decryptInPlace(inputData.data(), inputData.size());
     
     // 写入输出文件
     std::ofstream outFile(outputFilename, std::ios::binary);
@@ -87,41 +320,130 @@ bool EaglsEncryption::decryptFile(const std::string& inputFilename, const std::s
         return false;
     }
     
-    outFile.write(reinterpret_cast<const char*>(outputData.data()), outputData.size());
+    outFile.write(reinterpret_cast<const char*>(inputData.data()), inputData.size());
     outFile.close();
     
     return true;
 }
 
-LehmerEncryption::LehmerEncryption() : m_key("EAGLS_SYSTEM") {
+LehmerEncryption::LehmerEncryption() : LehmerEncryption(KeyProfileRegistry::getDefault()) {
+}
+
+LehmerEncryption::LehmerEncryption(const KeyProfile& profile)
+    : m_profile(profile), m_builtin(profile.usesBuiltinGrCipher()) {
 }
 
 std::vector<uint8_t> LehmerEncryption::encrypt(const std::vector<uint8_t>& data) {
+    // 复制数据，在副本上加密
+    std::vector<uint8_t> result = data;
+    encryptInPlace(result.data(), result.size());
+    return result;
+}
+
+std::vector<uint8_t> LehmerEncryption::decrypt(const std::vector<uint8_t>& data) {
+    // 加密和解密使用相同的算法
+    return encrypt(data);
+}
+
+void LehmerEncryption::encryptInPlace(uint8_t* data, size_t size) {
     // 如果数据为空，直接返回
-    if (data.empty()) {
-        return data;
+    if (size == 0) {
+        return;
     }
     
-    // 复制数据，因为我们需要修改它
-    std::vector<uint8_t> result = data;
+    if (!m_builtin) {
+        makeGrCipher(m_profile).apply(data, size - 1, cipher::grSeed(data[size - 1]));
+        return;
+    }
     
-    // 设置随机数种子
-    m_rng.srand(data.back());
+    // 加密限制，只处理开头的部分
+    const size_t limit = std::min(size - 1, KeystreamCache::LEHMER_LIMIT);
     
-    // 加密限制
-    const size_t limit = std::min(data.size() - 1, static_cast<size_t>(0x174b));
+    // 与该种子的密钥流异或
+    KeystreamCache::Keystream stream = KeystreamCache::getLehmer(data[size - 1]);
+    xorKeystream(data, stream->data(), limit);
+}
+
+void LehmerEncryption::decryptInPlace(uint8_t* data, size_t size) {
+    // 加密和解密使用相同的算法
+    encryptInPlace(data, size);
+}
+
+void LehmerEncryption::decryptRange(uint8_t* data, size_t offset, size_t size, size_t fileSize, uint8_t seed) {
+    if (fileSize == 0) {
+        return;
+    }
     
-    // 加密数据
-    for (size_t i = 0; i < limit; ++i) {
-        result[i] ^= m_key[m_rng.rand() % m_key.size()];
+    // 加密区域为 [0, min(fileSize - 1, lehmerLimit))
+    const size_t limit = m_builtin ? KeystreamCache::LEHMER_LIMIT : m_profile.lehmerLimit;
+    const size_t end = std::min({offset + size, fileSize - 1, limit});
+    if (offset >= end) {
+        return;
     }
     
-    return result;
+    if (m_builtin) {
+        KeystreamCache::Keystream stream = KeystreamCache::getLehmer(seed);
+        xorKeystream(data, stream->data() + offset, end - offset);
+    } else {
+        std::vector<uint8_t> keystream(end - offset);
+        makeGrCipher(m_profile).keystream(cipher::grSeed(seed), offset, keystream.data(), keystream.size());
+        xorKeystream(data, keystream.data(), keystream.size());
+    }
 }
 
-std::vector<uint8_t> LehmerEncryption::decrypt(const std::vector<uint8_t>& data) {
+KeystreamCache::Keystream LehmerEncryption::getKeystream(uint8_t seed) const {
+    if (m_builtin) {
+        return KeystreamCache::getLehmer(seed);
+    }
+    
+    auto stream = std::make_shared<std::vector<uint8_t>>(m_profile.lehmerLimit);
+    makeGrCipher(m_profile).keystream(cipher::grSeed(seed), 0, stream->data(), stream->size());
+    return stream;
+}
+
+IndexEncryption::IndexEncryption() : IndexEncryption(KeyProfileRegistry::getDefault()) {
+}
+
+IndexEncryption::IndexEncryption(const KeyProfile& profile)
+    : m_profile(profile), m_builtin(profile.usesBuiltinIndexCipher()) {
+}
+
+void IndexEncryption::encryptInPlace(uint8_t* data, size_t size) {
     // 加密和解密使用相同的算法
-    return encrypt(data);
+    decryptInPlace(data, size);
+}
+
+void IndexEncryption::decryptInPlace(uint8_t* data, size_t size) {
+    if (size <= 4) {
+        return;
+    }
+    
+    // 尾部4字节为种子，不加密
+    uint32_t seed;
+    std::memcpy(&seed, data + size - 4, sizeof(seed));
+    
+    if (!m_builtin) {
+        makeIndexCipher(m_profile).apply(data, size - 4, seed);
+        return;
+    }
+    
+    KeystreamCache::Keystream stream = KeystreamCache::getIndex(seed, size - 4);
+    xorKeystream(data, stream->data(), size - 4);
+}
+
+void IndexEncryption::decryptRange(uint8_t* data, size_t offset, size_t size, uint32_t seed) {
+    if (size == 0) {
+        return;
+    }
+    
+    // 生成器可以直接跳到offset，不需要前面的密钥流
+    std::vector<uint8_t> keystream(size);
+    if (m_builtin) {
+        KeystreamCache::generateIndex(seed, offset, keystream.data(), size);
+    } else {
+        makeIndexCipher(m_profile).keystream(seed, offset, keystream.data(), size);
+    }
+    xorKeystream(data, keystream.data(), size);
 }
 
 } // namespace encryption
@@ -0,0 +1,109 @@
+﻿#include "core/encryption/key_profile.h"
+#include "core/encryption/eagls_cipher.h"
+#include <iostream>
+#include <mutex>
+
+namespace eagls {
+namespace encryption {
+
+namespace {
+
+/**
+ * @brief 由内置加密模板的参数构成的配置
+ */
+KeyProfile makeDefaultProfile() {
+    KeyProfile profile;
+    profile.name = "eagls";
+    profile.indexKey = cipher::INDEX_KEY;
+    profile.eaglsKey = cipher::EAGLS_KEY;
+    profile.indexSize = 0x61a84;
+    profile.indexEntrySize = 0x28;
+    profile.indexNameSize = 0x18;
+    profile.pakDataOffset = 0x174b;
+    profile.lehmerLimit = cipher::GrCipher::LIMIT;
+    profile.datTextOffset = cipher::DatCipher::OFFSET;
+    profile.datSectionEntrySize = 0x24;
+    profile.datSectionNameSize = 0x20;
+    return profile;
+}
+
+std::mutex& getMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<KeyProfile>& getTable() {
+    static std::vector<KeyProfile> table = { KeyProfileRegistry::getDefault() };
+    return table;
+}
+
+} // namespace
+
+bool KeyProfile::isValid() const {
+    // 索引条目：文件名 + 8字节偏移 + 4字节大小 + 4字节标志
+    if (name.empty() || indexKey.empty() || eaglsKey.empty()) {
+        return false;
+    }
+    if (indexEntrySize < indexNameSize + 16 || indexSize < indexEntrySize + 4) {
+        return false;
+    }
+    // DAT段表条目：段名 + 4字节偏移，且段表至少容纳一个条目
+    if (datSectionEntrySize < datSectionNameSize + 4 || datTextOffset < datSectionEntrySize) {
+        return false;
+    }
+    return true;
+}
+
+bool KeyProfile::usesBuiltinGrCipher() const {
+    return eaglsKey == cipher::EAGLS_KEY && lehmerLimit == cipher::GrCipher::LIMIT;
+}
+
+bool KeyProfile::usesBuiltinDatCipher() const {
+    return eaglsKey == cipher::EAGLS_KEY && datTextOffset == cipher::DatCipher::OFFSET;
+}
+
+bool KeyProfile::usesBuiltinIndexCipher() const {
+    return indexKey == cipher::INDEX_KEY;
+}
+
+const KeyProfile& KeyProfileRegistry::getDefault() {
+    static const KeyProfile profile = makeDefaultProfile();
+    return profile;
+}
+
+std::vector<KeyProfile> KeyProfileRegistry::getProfiles() {
+    std::lock_guard<std::mutex> lock(getMutex());
+    return getTable();
+}
+
+bool KeyProfileRegistry::findProfile(const std::string& name, KeyProfile& profile) {
+    std::lock_guard<std::mutex> lock(getMutex());
+    for (const auto& candidate : getTable()) {
+        if (candidate.name == name) {
+            profile = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KeyProfileRegistry::registerProfile(const KeyProfile& profile) {
+    if (!profile.isValid()) {
+        std::cerr << "Error: Invalid key profile: " << profile.name << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(getMutex());
+    std::vector<KeyProfile>& table = getTable();
+    for (const auto& candidate : table) {
+        if (candidate.name == profile.name) {
+            std::cerr << "Error: Key profile already registered: " << profile.name << std::endl;
+            return false;
+        }
+    }
+    table.push_back(profile);
+    return true;
+}
+
+} // namespace encryption
+} // namespace eagls
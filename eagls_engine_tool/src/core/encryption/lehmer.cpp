@@ -3,43 +3,38 @@
 namespace eagls {
 namespace encryption {
 
-LehmerRandomGenerator::LehmerRandomGenerator() : m_seed(0) {
+LehmerRandomGenerator::LehmerRandomGenerator() : m_rng() {
 }
 
 void LehmerRandomGenerator::srand(uint32_t seed) {
-    m_seed = seed ^ 123459876;
+    m_rng.srand(seed);
 }
 
 uint32_t LehmerRandomGenerator::rand() {
-    // 计算 m_seed = (48271 * (m_seed % 44488) - 3399 * (m_seed / 44488))
-    int32_t high = m_seed / 44488;
-    int32_t low = m_seed % 44488;
-    
-    m_seed = 48271 * low - 3399 * high;
-    
-    // 如果结果为负，加上模数
-    if (m_seed < 0) {
-        m_seed += 2147483647;
-    }
-    
-    // 确保结果在32位范围内
-    m_seed &= 0xFFFFFFFF;
-    
     // 返回0-255范围的随机数
-    return static_cast<uint32_t>(m_seed * 4.656612875245797e-10 * 256) & 0xFFFFFFFF;
+    return m_rng.rand();
 }
 
-CRuntimeRandomGenerator::CRuntimeRandomGenerator() : m_seed(0) {
+CRuntimeRandomGenerator::CRuntimeRandomGenerator() : m_rng() {
 }
 
 void CRuntimeRandomGenerator::srand(uint32_t seed) {
-    m_seed = seed;
+    m_rng.srand(seed);
 }
 
 uint32_t CRuntimeRandomGenerator::rand() {
     // 标准C运行时随机数生成算法
-    m_seed = (m_seed * 214013 + 2531011) & 0xFFFFFFFF;
-    return (m_seed >> 16) & 0x7FFF;
+    return m_rng.rand();
+}
+
+void CRuntimeRandomGenerator::discard(uint64_t n) {
+    m_rng.discard(n);
+}
+
+uint32_t CRuntimeRandomGenerator::at(uint64_t n) const {
+    CRuntimeRandomGenerator rng = *this;
+    rng.discard(n);
+    return rng.rand();
 }
 
 } // namespace encryption
@@ -0,0 +1,178 @@
+﻿#include "core/encryption/xor_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define EAGLS_XOR_KERNELS_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// 只为单个函数开启SSE2/AVX2，整个项目仍按基础指令集编译
+#if defined(__GNUC__) || defined(__clang__)
+    #define EAGLS_TARGET_SSE2 __attribute__((target("sse2")))
+    #define EAGLS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define EAGLS_TARGET_SSE2
+    #define EAGLS_TARGET_AVX2
+#endif
+
+namespace eagls {
+namespace encryption {
+
+namespace {
+
+using XorFn = void (*)(uint8_t* data, const uint8_t* key, size_t size);
+
+void xorScalar(uint8_t* data, const uint8_t* key, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        data[i] ^= key[i];
+    }
+}
+
+void xorStride2Scalar(uint8_t* data, const uint8_t* key, size_t keySize) {
+    for (size_t i = 0; i < keySize; ++i) {
+        data[2 * i] ^= key[i];
+    }
+}
+
+#ifdef EAGLS_XOR_KERNELS_X86
+
+EAGLS_TARGET_SSE2
+void xorSse2(uint8_t* data, const uint8_t* key, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i* out = reinterpret_cast<__m128i*>(data + i);
+        _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i))));
+    }
+    xorScalar(data + i, key + i, size - i);
+}
+
+/*
+ * 步长2：16字节密钥与0交错成32字节，覆盖数据的 [2i, 2i + 32)。
+ * 最后一个密钥字节对应的数据之后不一定还有可写的字节，所以整块处理时保证块后仍有密钥剩余。
+ */
+EAGLS_TARGET_SSE2
+void xorStride2Sse2(uint8_t* data, const uint8_t* key, size_t keySize) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 < keySize; i += 16) {
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i));
+        __m128i* out = reinterpret_cast<__m128i*>(data + 2 * i);
+        _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out), _mm_unpacklo_epi8(k, zero)));
+        _mm_storeu_si128(out + 1, _mm_xor_si128(_mm_loadu_si128(out + 1), _mm_unpackhi_epi8(k, zero)));
+    }
+    xorStride2Scalar(data + 2 * i, key + i, keySize - i);
+}
+
+EAGLS_TARGET_AVX2
+void xorAvx2(uint8_t* data, const uint8_t* key, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i* out = reinterpret_cast<__m256i*>(data + i);
+        _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(out),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + i))));
+    }
+    xorScalar(data + i, key + i, size - i);
+}
+
+EAGLS_TARGET_AVX2
+void xorStride2Avx2(uint8_t* data, const uint8_t* key, size_t keySize) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 < keySize; i += 32) {
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + i));
+        // unpack在每个128位通道内进行，再交换中间两个通道恢复顺序
+        __m256i lo = _mm256_unpacklo_epi8(k, zero);
+        __m256i hi = _mm256_unpackhi_epi8(k, zero);
+        __m256i* out = reinterpret_cast<__m256i*>(data + 2 * i);
+        _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(out), _mm256_permute2x128_si256(lo, hi, 0x20)));
+        _mm256_storeu_si256(out + 1, _mm256_xor_si256(_mm256_loadu_si256(out + 1), _mm256_permute2x128_si256(lo, hi, 0x31)));
+    }
+    xorStride2Scalar(data + 2 * i, key + i, keySize - i);
+}
+
+bool cpuSupportsSse2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpuSupportsAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // 需要操作系统保存YMM寄存器状态
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif // EAGLS_XOR_KERNELS_X86
+
+/**
+ * @brief 第一次使用时选定的实现
+ */
+struct XorKernels {
+    XorFn contiguous = xorScalar;
+    XorFn stride2 = xorStride2Scalar;
+    const char* name = "scalar";
+
+    XorKernels() {
+#ifdef EAGLS_XOR_KERNELS_X86
+        if (cpuSupportsSse2()) {
+            contiguous = xorSse2;
+            stride2 = xorStride2Sse2;
+            name = "sse2";
+        }
+        if (cpuSupportsAvx2()) {
+            contiguous = xorAvx2;
+            stride2 = xorStride2Avx2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+const XorKernels& getKernels() {
+    static const XorKernels kernels;
+    return kernels;
+}
+
+} // namespace
+
+void xorKeystream(uint8_t* data, const uint8_t* key, size_t size) {
+    getKernels().contiguous(data, key, size);
+}
+
+void xorKeystreamStride2(uint8_t* data, const uint8_t* key, size_t keySize) {
+    getKernels().stride2(data, key, keySize);
+}
+
+const char* getXorKernelName() {
+    return getKernels().name;
+}
+
+} // namespace encryption
+} // namespace eagls
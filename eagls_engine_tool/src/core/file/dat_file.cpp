@@ -12,20 +12,24 @@
 namespace eagls {
 namespace file {
 
-// DAT文件格式常量
+// DAT文件格式常量，段表大小（即文本偏移）和段条目布局由密钥配置给出
 constexpr size_t SECTION_TABLE_OFFSET = 0;    // 段表偏移
-constexpr size_t SECTION_TABLE_SIZE = 0xE10;  // 段表大小
-constexpr size_t TEXT_OFFSET = 0xE10;         // 文本偏移
-constexpr size_t SECTION_NAME_SIZE = 0x20;    // 段名大小
-constexpr size_t SECTION_ENTRY_SIZE = 0x24;   // 段条目大小
 
-DatFile::DatFile() : m_isOpen(false) {
+DatFile::DatFile() : m_isOpen(false), m_profile(encryption::KeyProfileRegistry::getDefault()) {
 }
 
 DatFile::~DatFile() {
     close();
 }
 
+void DatFile::setProfile(const encryption::KeyProfile& profile) {
+    m_profile = profile;
+}
+
+const encryption::KeyProfile& DatFile::getProfile() const {
+    return m_profile;
+}
+
 bool DatFile::open(const std::string& filename, bool decrypt) {
     // 关闭已打开的文件
     close();
@@ -39,8 +43,8 @@ bool DatFile::open(const std::string& filename, bool decrypt) {
     
     // 如果需要解密
     if (decrypt) {
-        encryption::EaglsEncryption enc;
-        m_data = enc.decrypt(m_data);
+        encryption::EaglsEncryption enc(m_profile);
+        enc.decryptInPlace(m_data.data(), m_data.size());
     }
     
     // 解析段表
@@ -324,7 +328,7 @@ bool DatFile::replaceText(const std::string& textFilename, const std::string& ou
     updateSectionTable();
     
     // 加密数据
-    encryption::EaglsEncryption enc;
+    encryption::EaglsEncryption enc(m_profile);
     std::vector<uint8_t> encryptedData = enc.encrypt(m_data);
     
     // 写入输出文件
@@ -336,13 +340,14 @@ bool DatFile::create(const std::string& filename, const std::map<std::string, st
     close();
     
     // 检查段数
-    if (sections.empty() || sections.size() > 100) {  // 假设最多支持100个段
+    if (sections.empty() || sections.size() > 100 ||  // 假设最多支持100个段
+        sections.size() * m_profile.datSectionEntrySize > m_profile.datTextOffset) {
         std::cerr << "Error: Invalid number of sections: " << sections.size() << std::endl;
         return false;
     }
     
     // 创建段表
-    std::vector<uint8_t> sectionTable(SECTION_TABLE_SIZE, 0);
+    std::vector<uint8_t> sectionTable(m_profile.datTextOffset, 0);
     
     // 计算文本部分的大小
     size_t textSize = 0;
@@ -351,29 +356,29 @@ bool DatFile::create(const std::string& filename, const std::map<std::string, st
     }
     
     // 创建文件数据
-    m_data.resize(TEXT_OFFSET + textSize);
+    m_data.resize(m_profile.datTextOffset + textSize);
     std::fill(m_data.begin(), m_data.end(), 0);
     
     // 写入段数据
-    size_t offset = TEXT_OFFSET;
+    size_t offset = m_profile.datTextOffset;
     size_t sectionIndex = 0;
     
     for (const auto& section : sections) {
         // 检查段名长度
-        if (section.first.length() >= SECTION_NAME_SIZE) {
+        if (section.first.length() >= m_profile.datSectionNameSize) {
             std::cerr << "Error: Section name too long: " << section.first << std::endl;
             return false;
         }
         
         // 写入段表条目
-        size_t tableOffset = sectionIndex * SECTION_ENTRY_SIZE;
+        size_t tableOffset = sectionIndex * m_profile.datSectionEntrySize;
         
         // 写入段名
         std::copy(section.first.begin(), section.first.end(), sectionTable.begin() + tableOffset);
         
         // 写入段偏移
-        uint32_t sectionOffset = static_cast<uint32_t>(offset - TEXT_OFFSET);
-        std::memcpy(&sectionTable[tableOffset + SECTION_NAME_SIZE], &sectionOffset, sizeof(uint32_t));
+        uint32_t sectionOffset = static_cast<uint32_t>(offset - m_profile.datTextOffset);
+        std::memcpy(&sectionTable[tableOffset + m_profile.datSectionNameSize], &sectionOffset, sizeof(uint32_t));
         
         // 写入段数据
         std::copy(section.second.begin(), section.second.end(), m_data.begin() + offset);
@@ -397,8 +402,8 @@ bool DatFile::create(const std::string& filename, const std::map<std::string, st
     // 如果需要加密
     std::vector<uint8_t> outputData = m_data;
     if (encrypt) {
-        encryption::EaglsEncryption enc;
-        outputData = enc.encrypt(m_data);
+        encryption::EaglsEncryption enc(m_profile);
+        enc.encryptInPlace(outputData.data(), outputData.size());
     }
     
     // 写入文件
@@ -419,45 +424,45 @@ bool DatFile::parseSectionTable() {
     m_sections.clear();
     
     // 检查文件大小
-    if (m_data.size() <= SECTION_TABLE_SIZE) {
+    if (m_data.size() <= m_profile.datTextOffset) {
         std::cerr << "Error: DAT file too small" << std::endl;
         return false;
     }
     
     // 解析段表
     for (size_t i = 0; i < 100; ++i) {  // 假设最多100个段
-        size_t offset = SECTION_TABLE_OFFSET + i * SECTION_ENTRY_SIZE;
+        size_t offset = SECTION_TABLE_OFFSET + i * m_profile.datSectionEntrySize;
         
         // 检查是否到达段表末尾
-        if (offset + SECTION_ENTRY_SIZE > SECTION_TABLE_SIZE || m_data[offset] == 0) {
+        if (offset + m_profile.datSectionEntrySize > m_profile.datTextOffset || m_data[offset] == 0) {
             break;
         }
         
         // 读取段名
-        char name[SECTION_NAME_SIZE + 1] = {0};
-        std::memcpy(name, &m_data[offset], SECTION_NAME_SIZE);
+        const char* namePtr = reinterpret_cast<const char*>(&m_data[offset]);
+        std::string name(namePtr, strnlen(namePtr, m_profile.datSectionNameSize));
         
         // 读取段偏移
-        uint32_t sectionOffset = *reinterpret_cast<uint32_t*>(&m_data[offset + SECTION_NAME_SIZE]);
+        uint32_t sectionOffset = *reinterpret_cast<uint32_t*>(&m_data[offset + m_profile.datSectionNameSize]);
         
         // 计算段大小（通过查找下一个段的偏移或文件结尾）
         uint32_t sectionSize = 0;
         if (i + 1 < 100) {
-            size_t nextOffset = offset + SECTION_ENTRY_SIZE;
-            if (nextOffset + SECTION_ENTRY_SIZE <= SECTION_TABLE_SIZE && m_data[nextOffset] != 0) {
-                uint32_t nextSectionOffset = *reinterpret_cast<uint32_t*>(&m_data[nextOffset + SECTION_NAME_SIZE]);
+            size_t nextOffset = offset + m_profile.datSectionEntrySize;
+            if (nextOffset + m_profile.datSectionEntrySize <= m_profile.datTextOffset && m_data[nextOffset] != 0) {
+                uint32_t nextSectionOffset = *reinterpret_cast<uint32_t*>(&m_data[nextOffset + m_profile.datSectionNameSize]);
                 sectionSize = nextSectionOffset - sectionOffset;
             } else {
-                sectionSize = static_cast<uint32_t>(m_data.size() - (TEXT_OFFSET + sectionOffset));
+                sectionSize = static_cast<uint32_t>(m_data.size() - (m_profile.datTextOffset + sectionOffset));
             }
         } else {
-            sectionSize = static_cast<uint32_t>(m_data.size() - (TEXT_OFFSET + sectionOffset));
+            sectionSize = static_cast<uint32_t>(m_data.size() - (m_profile.datTextOffset + sectionOffset));
         }
         
         // 创建段条目
         DatEntry entry;
         entry.name = name;
-        entry.offset = TEXT_OFFSET + sectionOffset;
+        entry.offset = m_profile.datTextOffset + sectionOffset;
         entry.size = sectionSize;
         
         // 添加到段映射
@@ -475,23 +480,23 @@ bool DatFile::isPureAscii(const std::string& str) const {
 void DatFile::updateSectionTable() {
     // 更新段表
     for (size_t i = 0; i < 100; ++i) {  // 假设最多100个段
-        size_t offset = SECTION_TABLE_OFFSET + i * SECTION_ENTRY_SIZE;
+        size_t offset = SECTION_TABLE_OFFSET + i * m_profile.datSectionEntrySize;
         
         // 检查是否到达段表末尾
-        if (offset + SECTION_ENTRY_SIZE > SECTION_TABLE_SIZE || m_data[offset] == 0) {
+        if (offset + m_profile.datSectionEntrySize > m_profile.datTextOffset || m_data[offset] == 0) {
             break;
         }
         
         // 读取段名
-        char name[SECTION_NAME_SIZE + 1] = {0};
-        std::memcpy(name, &m_data[offset], SECTION_NAME_SIZE);
+        const char* namePtr = reinterpret_cast<const char*>(&m_data[offset]);
+        std::string name(namePtr, strnlen(namePtr, m_profile.datSectionNameSize));
         
         // 查找段
         auto it = m_sections.find(name);
         if (it != m_sections.end()) {
             // 更新段偏移
-            uint32_t sectionOffset = static_cast<uint32_t>(it->second.offset - TEXT_OFFSET);
-            std::memcpy(&m_data[offset + SECTION_NAME_SIZE], &sectionOffset, sizeof(uint32_t));
+            uint32_t sectionOffset = static_cast<uint32_t>(it->second.offset - m_profile.datTextOffset);
+            std::memcpy(&m_data[offset + m_profile.datSectionNameSize], &sectionOffset, sizeof(uint32_t));
         }
     }
 }
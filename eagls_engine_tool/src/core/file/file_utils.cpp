@@ -4,6 +4,16 @@
 #include <filesystem>
 #include <system_error>
 
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 namespace eagls {
@@ -49,6 +59,35 @@ bool FileUtils::writeFile(const std::string& filename, const std::vector<uint8_t
     return file.good();
 }
 
+bool FileUtils::syncFile(const std::string& filename) {
+#ifdef _WIN32
+    std::error_code ec;
+    if (fs::is_directory(filename, ec)) {
+        return true;
+    }
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot open file for syncing: " << filename << std::endl;
+        return false;
+    }
+    const bool success = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open file for syncing: " << filename << std::endl;
+        return false;
+    }
+    const bool success = ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    if (!success) {
+        std::cerr << "Error: Failed to sync file to disk: " << filename << std::endl;
+    }
+    return success;
+}
+
 size_t FileUtils::getFileSize(const std::string& filename) {
     std::error_code ec;
     auto size = fs::file_size(filename, ec);
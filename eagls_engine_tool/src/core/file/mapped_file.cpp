@@ -0,0 +1,198 @@
+﻿#include "core/file/mapped_file.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace eagls {
+namespace file {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : m_handle(INVALID_HANDLE_VALUE), m_mapping(nullptr), m_data(nullptr), m_size(0), m_isOpen(false) {
+}
+
+#else
+
+MappedFile::MappedFile() : m_fd(-1), m_data(nullptr), m_size(0), m_isOpen(false) {
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename, bool useMapping) {
+    close();
+
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize)) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    m_handle = handle;
+    m_size = static_cast<uint64_t>(fileSize.QuadPart);
+    m_isOpen = true;
+
+    // 空文件无法映射；映射失败时退回到按偏移读取
+    if (useMapping && m_size > 0 && m_size <= std::numeric_limits<size_t>::max()) {
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view) {
+                m_mapping = mapping;
+                m_data = static_cast<const uint8_t*>(view);
+            } else {
+                CloseHandle(mapping);
+            }
+        }
+    }
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+    m_isOpen = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename, bool useMapping) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_size = static_cast<uint64_t>(st.st_size);
+    m_isOpen = true;
+
+    // 空文件无法映射；映射失败时退回到按偏移读取
+    if (useMapping && m_size > 0 && m_size <= std::numeric_limits<size_t>::max()) {
+        void* view = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (view != MAP_FAILED) {
+            m_data = static_cast<const uint8_t*>(view);
+        }
+    }
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), static_cast<size_t>(m_size));
+        m_data = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_isOpen = false;
+}
+
+#endif
+
+bool MappedFile::isOpen() const {
+    return m_isOpen;
+}
+
+bool MappedFile::isMapped() const {
+    return m_data != nullptr;
+}
+
+uint64_t MappedFile::size() const {
+    return m_size;
+}
+
+const uint8_t* MappedFile::data() const {
+    return m_data;
+}
+
+bool MappedFile::read(uint64_t offset, void* buffer, size_t size) const {
+    if (!m_isOpen || offset > m_size || size > m_size - offset) {
+        return false;
+    }
+
+    if (m_data) {
+        std::memcpy(buffer, m_data + offset, size);
+        return true;
+    }
+
+    // 按偏移读取，可能分多次完成
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    while (size > 0) {
+#ifdef _WIN32
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD bytesRead = 0;
+        if (!ReadFile(m_handle, out, chunk, &bytesRead, &overlapped) || bytesRead == 0) {
+            return false;
+        }
+        const size_t n = bytesRead;
+#else
+        const ssize_t result = pread(m_fd, out, size, static_cast<off_t>(offset));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        const size_t n = static_cast<size_t>(result);
+#endif
+        out += n;
+        offset += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+} // namespace file
+} // namespace eagls
@@ -0,0 +1,186 @@
+﻿#include "pak_copy.h"
+#include <algorithm>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #ifdef __linux__
+        #include <sys/sendfile.h>
+    #endif
+#endif
+
+namespace eagls {
+namespace file {
+namespace detail {
+
+#ifdef _WIN32
+
+RangeCopier::RangeCopier() : m_kernelBytes(0) {
+}
+
+RangeCopier::~RangeCopier() {
+    close();
+}
+
+bool RangeCopier::open(const std::string& source, const std::string& target) {
+    close();
+    m_in.open(source, std::ios::binary);
+    m_out.open(target, std::ios::binary | std::ios::trunc);
+    return m_in && m_out;
+}
+
+bool RangeCopier::copy(uint64_t offset, uint64_t size) {
+    return copyBuffered(offset, size);
+}
+
+bool RangeCopier::close() {
+    bool success = true;
+    if (m_out.is_open()) {
+        m_out.close();
+        success = !m_out.fail();
+    }
+    if (m_in.is_open()) {
+        m_in.close();
+    }
+    m_in.clear();
+    m_out.clear();
+    return success;
+}
+
+bool RangeCopier::copyBuffered(uint64_t offset, uint64_t size) {
+    if (m_buffer.empty()) {
+        m_buffer.resize(COPY_BUFFER_SIZE);
+    }
+
+    m_in.seekg(offset);
+    while (size > 0) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, m_buffer.size()));
+        m_in.read(reinterpret_cast<char*>(m_buffer.data()), chunk);
+        if (static_cast<size_t>(m_in.gcount()) != chunk) {
+            return false;
+        }
+        m_out.write(reinterpret_cast<const char*>(m_buffer.data()), chunk);
+        if (!m_out) {
+            return false;
+        }
+        size -= chunk;
+    }
+    return true;
+}
+
+#else
+
+RangeCopier::RangeCopier()
+    : m_in(-1), m_out(-1), m_useCopyFileRange(true), m_useSendfile(true), m_kernelBytes(0) {
+}
+
+RangeCopier::~RangeCopier() {
+    close();
+}
+
+bool RangeCopier::open(const std::string& source, const std::string& target) {
+    close();
+    m_in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    m_out = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return m_in >= 0 && m_out >= 0;
+}
+
+bool RangeCopier::copy(uint64_t offset, uint64_t size) {
+#ifdef __linux__
+    // 目标总是写在当前位置，三种方式可以在一次复制中途切换
+    off_t position = static_cast<off_t>(offset);
+    while (size > 0 && m_useCopyFileRange) {
+        const ssize_t result = copy_file_range(m_in, &position, m_out, nullptr, static_cast<size_t>(size), 0);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+            m_useCopyFileRange = false;
+            break;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        m_kernelBytes += static_cast<uint64_t>(result);
+        size -= static_cast<uint64_t>(result);
+    }
+    while (size > 0 && m_useSendfile) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, 0x7ffff000));
+        const ssize_t result = sendfile(m_out, m_in, &position, chunk);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && (errno == ENOSYS || errno == EINVAL)) {
+            m_useSendfile = false;
+            break;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        m_kernelBytes += static_cast<uint64_t>(result);
+        size -= static_cast<uint64_t>(result);
+    }
+    offset = static_cast<uint64_t>(position);
+#endif
+    return size == 0 || copyBuffered(offset, size);
+}
+
+bool RangeCopier::close() {
+    bool success = true;
+    if (m_out >= 0) {
+        success = ::close(m_out) == 0;
+        m_out = -1;
+    }
+    if (m_in >= 0) {
+        ::close(m_in);
+        m_in = -1;
+    }
+    return success;
+}
+
+bool RangeCopier::copyBuffered(uint64_t offset, uint64_t size) {
+    if (m_buffer.empty()) {
+        m_buffer.resize(COPY_BUFFER_SIZE);
+    }
+
+    while (size > 0) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, m_buffer.size()));
+        const ssize_t result = pread(m_in, m_buffer.data(), chunk, static_cast<off_t>(offset));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+
+        // 按读到的字节数写出，可能分多次完成
+        const uint8_t* data = m_buffer.data();
+        size_t remaining = static_cast<size_t>(result);
+        while (remaining > 0) {
+            const ssize_t written = write(m_out, data, remaining);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+
+        offset += static_cast<uint64_t>(result);
+        size -= static_cast<uint64_t>(result);
+    }
+    return true;
+}
+
+#endif
+
+uint64_t RangeCopier::getKernelBytes() const {
+    return m_kernelBytes;
+}
+
+} // namespace detail
+} // namespace file
+} // namespace eagls
@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+    #include <fstream>
+#endif
+
+namespace eagls {
+namespace file {
+namespace detail {
+
+// 内核复制不可用时每次读写的块大小
+constexpr size_t COPY_BUFFER_SIZE = 4 * 1024 * 1024;
+
+/**
+ * @brief 把源文件中的区间顺序复制到目标文件（PakFile内部使用）
+ *
+ * Linux上优先用copy_file_range在内核中复制（同一文件系统上可能只共享数据块），
+ * 不支持时改用sendfile，都不可用时退回到大块的读写。数据原样复制，不经过解密和加密。
+ */
+class RangeCopier {
+public:
+    RangeCopier();
+    ~RangeCopier();
+
+    RangeCopier(const RangeCopier&) = delete;
+    RangeCopier& operator=(const RangeCopier&) = delete;
+
+    /**
+     * @brief 打开源文件和目标文件，目标文件被截断
+     * @param source 源文件名
+     * @param target 目标文件名
+     * @return 是否成功
+     */
+    bool open(const std::string& source, const std::string& target);
+
+    /**
+     * @brief 把源文件的一段追加到目标文件
+     * @param offset 源文件偏移
+     * @param size 字节数
+     * @return 是否完整复制
+     */
+    bool copy(uint64_t offset, uint64_t size);
+
+    /**
+     * @brief 关闭两个文件
+     * @return 目标文件是否全部写入成功
+     */
+    bool close();
+
+    /**
+     * @brief 获取在内核中复制的字节数
+     */
+    uint64_t getKernelBytes() const;
+
+private:
+#ifdef _WIN32
+    std::ifstream m_in;             // 源文件
+    std::ofstream m_out;            // 目标文件
+#else
+    int m_in;                       // 源文件描述符
+    int m_out;                      // 目标文件描述符
+    bool m_useCopyFileRange;        // copy_file_range是否可用
+    bool m_useSendfile;             // sendfile是否可用
+#endif
+    std::vector<uint8_t> m_buffer;  // 读写缓冲区
+    uint64_t m_kernelBytes;         // 在内核中复制的字节数
+
+    /**
+     * @brief 通过缓冲区复制
+     */
+    bool copyBuffered(uint64_t offset, uint64_t size);
+};
+
+} // namespace detail
+} // namespace file
+} // namespace eagls
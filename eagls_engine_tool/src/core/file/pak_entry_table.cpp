@@ -0,0 +1,236 @@
+﻿#include "core/file/pak_entry_table.h"
+#include <algorithm>
+#include <cstring>
+
+namespace eagls {
+namespace file {
+
+namespace {
+
+// 哈希表的最小槽数，槽数保持为2的幂且不少于条目数的2倍
+constexpr size_t MIN_SLOTS = 16;
+
+inline char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // namespace
+
+PakEntryTable::PakEntryTable(size_t nameSize, bool caseInsensitive)
+    : m_nameSize(nameSize), m_caseInsensitive(caseInsensitive) {
+}
+
+void PakEntryTable::reset(size_t nameSize, bool caseInsensitive) {
+    m_nameSize = nameSize;
+    m_caseInsensitive = caseInsensitive;
+    clear();
+}
+
+void PakEntryTable::clear() {
+    m_names.clear();
+    m_offsets.clear();
+    m_sizes.clear();
+    m_flags.clear();
+    m_hashes.clear();
+    m_slots.clear();
+    m_byOffset.clear();
+}
+
+void PakEntryTable::reserve(size_t count) {
+    m_names.reserve(count * m_nameSize);
+    m_offsets.reserve(count);
+    m_sizes.reserve(count);
+    m_flags.reserve(count);
+    m_hashes.reserve(count);
+    m_byOffset.reserve(count);
+
+    size_t slotCount = MIN_SLOTS;
+    while (slotCount < count * 2) {
+        slotCount *= 2;
+    }
+    if (slotCount > m_slots.size()) {
+        rehash(slotCount);
+    }
+}
+
+size_t PakEntryTable::size() const {
+    return m_offsets.size();
+}
+
+bool PakEntryTable::empty() const {
+    return m_offsets.empty();
+}
+
+size_t PakEntryTable::getNameSize() const {
+    return m_nameSize;
+}
+
+bool PakEntryTable::isCaseInsensitive() const {
+    return m_caseInsensitive;
+}
+
+bool PakEntryTable::isValidName(const std::string& name) const {
+    return !name.empty() && name.size() <= m_nameSize && name.find('\0') == std::string::npos;
+}
+
+uint32_t PakEntryTable::add(const std::string& name, uint64_t offset, uint32_t size, uint32_t flags) {
+    return add(name.data(), name.size(), offset, size, flags);
+}
+
+uint32_t PakEntryTable::add(const char* name, size_t length, uint64_t offset, uint32_t size, uint32_t flags) {
+    if (length == 0 || length > m_nameSize || std::memchr(name, '\0', length)) {
+        return NPOS;
+    }
+    const uint32_t hash = hashName(name, length);
+    if (findName(name, length, hash) != NPOS) {
+        return NPOS;
+    }
+
+    // 保持至多半满
+    if ((m_offsets.size() + 1) * 2 > m_slots.size()) {
+        rehash(std::max(MIN_SLOTS, m_slots.size() * 2));
+    }
+
+    const uint32_t index = static_cast<uint32_t>(m_offsets.size());
+    m_names.resize(m_names.size() + m_nameSize, '\0');
+    std::memcpy(&m_names[index * m_nameSize], name, length);
+    m_offsets.push_back(offset);
+    m_sizes.push_back(size);
+    m_flags.push_back(flags);
+    m_hashes.push_back(hash);
+    m_byOffset.push_back(index);
+
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = hash & mask;
+    while (m_slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    m_slots[slot] = index + 1;
+
+    return index;
+}
+
+uint32_t PakEntryTable::find(const std::string& name) const {
+    if (name.empty() || name.size() > m_nameSize) {
+        return NPOS;
+    }
+    return findName(name.data(), name.size(), hashName(name.data(), name.size()));
+}
+
+std::string PakEntryTable::getName(uint32_t index) const {
+    const char* field = getNameField(index);
+    return std::string(field, strnlen(field, m_nameSize));
+}
+
+const char* PakEntryTable::getNameField(uint32_t index) const {
+    return &m_names[index * m_nameSize];
+}
+
+uint64_t PakEntryTable::getOffset(uint32_t index) const {
+    return m_offsets[index];
+}
+
+uint32_t PakEntryTable::getSize(uint32_t index) const {
+    return m_sizes[index];
+}
+
+uint32_t PakEntryTable::getFlags(uint32_t index) const {
+    return m_flags[index];
+}
+
+PakEntry PakEntryTable::getEntry(uint32_t index) const {
+    PakEntry entry;
+    entry.name = getName(index);
+    entry.offset = m_offsets[index];
+    entry.size = m_sizes[index];
+    entry.flags = m_flags[index];
+    return entry;
+}
+
+void PakEntryTable::setLocation(uint32_t index, uint64_t offset, uint32_t size) {
+    m_offsets[index] = offset;
+    m_sizes[index] = size;
+}
+
+void PakEntryTable::sortByOffset() {
+    m_byOffset.resize(size());
+    for (uint32_t i = 0; i < m_byOffset.size(); ++i) {
+        m_byOffset[i] = i;
+    }
+    // 偏移相同时保持索引中的顺序
+    std::stable_sort(m_byOffset.begin(), m_byOffset.end(), [this](uint32_t a, uint32_t b) {
+        return m_offsets[a] < m_offsets[b];
+    });
+}
+
+const std::vector<uint32_t>& PakEntryTable::getOffsetOrder() const {
+    return m_byOffset;
+}
+
+std::vector<uint32_t> PakEntryTable::getNameOrder() const {
+    std::vector<uint32_t> order(size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    // 定长字段补0，按字节比较即为按文件名排序
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return std::memcmp(getNameField(a), getNameField(b), m_nameSize) < 0;
+    });
+    return order;
+}
+
+uint32_t PakEntryTable::hashName(const char* name, size_t length) const {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        const char c = m_caseInsensitive ? toLower(name[i]) : name[i];
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t PakEntryTable::findName(const char* name, size_t length, uint32_t hash) const {
+    if (m_slots.empty()) {
+        return NPOS;
+    }
+
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = hash & mask; m_slots[slot] != 0; slot = (slot + 1) & mask) {
+        const uint32_t index = m_slots[slot] - 1;
+        if (m_hashes[index] == hash && nameEquals(index, name, length)) {
+            return index;
+        }
+    }
+    return NPOS;
+}
+
+bool PakEntryTable::nameEquals(uint32_t index, const char* name, size_t length) const {
+    const char* field = getNameField(index);
+    if (length < m_nameSize && field[length] != '\0') {
+        return false;
+    }
+    if (!m_caseInsensitive) {
+        return std::memcmp(field, name, length) == 0;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (toLower(field[i]) != toLower(name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PakEntryTable::rehash(size_t slotCount) {
+    m_slots.assign(slotCount, 0);
+    const size_t mask = slotCount - 1;
+    for (uint32_t index = 0; index < size(); ++index) {
+        size_t slot = m_hashes[index] & mask;
+        while (m_slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = index + 1;
+    }
+}
+
+} // namespace file
+} // namespace eagls
@@ -1,31 +1,57 @@
 ﻿#include "core/file/pak_file.h"
 #include "core/file/file_utils.h"
 #include "core/encryption/eagls_encryption.h"
+#include "pak_stream.h"
+#include "pak_copy.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <cstdio>
+#include <numeric>
+#include <filesystem>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 namespace eagls {
 namespace file {
 
-// PAK文件格式常量
-constexpr size_t NAME_SIZE = 0x18;  // 文件名大小
-constexpr size_t ENTRY_SIZE = 0x28; // 条目大小
-constexpr size_t INDEX_SIZE = 0x61a84; // 索引大小
-constexpr size_t DATA_OFFSET = 0x174b; // 数据偏移
+// PAK文件格式参数（索引大小、条目布局、数据偏移）由密钥配置给出
 
-// 索引加密密钥
-const std::string INDEX_KEY = "1qaz2wsx3edc4rfv5tgb6yhn7ujm8ik,9ol.0p;/-@:^[]";
+// 批量提取时默认的未写完数据上限
+constexpr size_t DEFAULT_MAX_PENDING_BYTES = 64 * 1024 * 1024;
 
-PakFile::PakFile() : m_isOpen(false) {
+PakEntryView::PakEntryView() : m_data(nullptr), m_size(0) {
+}
+
+const uint8_t* PakEntryView::data() const {
+    return m_data;
+}
+
+size_t PakEntryView::size() const {
+    return m_size;
+}
+
+PakFile::PakFile()
+    : m_isOpen(false), m_caseInsensitive(false), m_threadCount(1), m_maxPendingBytes(DEFAULT_MAX_PENDING_BYTES),
+      m_profile(encryption::KeyProfileRegistry::getDefault()), m_indexSeed(0) {
 }
 
 PakFile::~PakFile() {
     close();
 }
 
-bool PakFile::open(const std::string& pakFilename) {
+void PakFile::setProfile(const encryption::KeyProfile& profile) {
+    m_profile = profile;
+}
+
+const encryption::KeyProfile& PakFile::getProfile() const {
+    return m_profile;
+}
+
+bool PakFile::open(const std::string& pakFilename, bool useMapping) {
     // 关闭已打开的文件
     close();
     
@@ -36,12 +62,7 @@ bool PakFile::open(const std::string& pakFilename) {
     }
     
     // 构造索引文件名
-    std::string idxFilename = pakFilename;
-    size_t extPos = idxFilename.rfind('.');
-    if (extPos != std::string::npos) {
-        idxFilename = idxFilename.substr(0, extPos);
-    }
-    idxFilename += ".idx";
+    const std::string idxFilename = getIndexFilename(pakFilename);
     
     // 检查索引文件是否存在
     if (!FileUtils::fileExists(idxFilename)) {
@@ -56,71 +77,141 @@ bool PakFile::open(const std::string& pakFilename) {
     }
     
     m_pakFilename = pakFilename;
+    
+    // 打开PAK文件数据，之后读取条目不再重新打开文件
+    if (!openData(useMapping)) {
+        m_entries.clear();
+        m_pakFilename.clear();
+        return false;
+    }
+    
     m_isOpen = true;
     
     return true;
 }
 
+bool PakFile::openData(bool useMapping) {
+    auto data = std::make_shared<MappedFile>();
+    if (!data->open(m_pakFilename, useMapping)) {
+        std::cerr << "Error: Cannot open PAK file: " << m_pakFilename << std::endl;
+        return false;
+    }
+    m_data = data;
+    return true;
+}
+
+bool PakFile::isMapped() const {
+    return m_data && m_data->isMapped();
+}
+
 void PakFile::close() {
+    m_data.reset();
     m_entries.clear();
+    m_records.clear();
     m_pakFilename.clear();
     m_isOpen = false;
 }
 
+void PakFile::setCaseInsensitiveLookup(bool caseInsensitive) {
+    m_caseInsensitive = caseInsensitive;
+}
+
 std::vector<std::string> PakFile::getFileList() const {
     std::vector<std::string> files;
+    files.reserve(m_entries.size());
     
-    for (const auto& entry : m_entries) {
-        files.push_back(entry.first);
+    for (uint32_t i = 0; i < m_entries.size(); ++i) {
+        files.push_back(m_entries.getName(i));
     }
     
     return files;
 }
 
-bool PakFile::extractFile(const std::string& filename, const std::string& outputPath, bool decrypt) {
-    if (!m_isOpen) {
+const PakEntryTable& PakFile::getEntries() const {
+    return m_entries;
+}
+
+bool PakFile::getEntryView(const std::string& filename, PakEntryView& view) const {
+    if (!m_isOpen || !m_data) {
         std::cerr << "Error: PAK file is not open" << std::endl;
         return false;
     }
     
     // 查找文件条目
-    auto it = m_entries.find(filename);
-    if (it == m_entries.end()) {
+    const uint32_t index = m_entries.find(filename);
+    if (index == PakEntryTable::NPOS) {
         std::cerr << "Error: File not found in PAK: " << filename << std::endl;
         return false;
     }
     
-    const PakEntry& entry = it->second;
-    
-    // 打开PAK文件
-    std::ifstream pakFile(m_pakFilename, std::ios::binary);
-    if (!pakFile) {
-        std::cerr << "Error: Cannot open PAK file: " << m_pakFilename << std::endl;
+    return getEntryViewAt(index, view);
+}
+
+bool PakFile::getEntryViewAt(uint32_t index, PakEntryView& view) const {
+    const uint64_t offset = m_entries.getOffset(index);
+    const uint32_t size = m_entries.getSize(index);
+    
+    // 索引中的偏移包含数据偏移
+    if (offset < m_profile.pakDataOffset ||
+        offset - m_profile.pakDataOffset > m_data->size() ||
+        size > m_data->size() - (offset - m_profile.pakDataOffset)) {
+        std::cerr << "Error: Invalid file offset in PAK: " << m_entries.getName(index) << std::endl;
         return false;
     }
+    const uint64_t position = offset - m_profile.pakDataOffset;
+    
+    view = PakEntryView();
+    view.m_file = m_data;
+    view.m_size = size;
+    
+    if (m_data->isMapped()) {
+        // 直接指向映射的内存
+        view.m_data = m_data->data() + position;
+    } else {
+        // 按偏移读取一份
+        auto buffer = std::make_shared<std::vector<uint8_t>>(size);
+        if (!m_data->read(position, buffer->data(), buffer->size())) {
+            std::cerr << "Error: Failed to read file data from PAK: " << m_entries.getName(index) << std::endl;
+            return false;
+        }
+        view.m_data = buffer->data();
+        view.m_buffer = buffer;
+    }
     
-    // 读取文件数据
-    pakFile.seekg(entry.offset);
-    std::vector<uint8_t> data(entry.size);
-    if (!pakFile.read(reinterpret_cast<char*>(data.data()), entry.size)) {
-        std::cerr << "Error: Failed to read file data from PAK: " << filename << std::endl;
+    return true;
+}
+
+bool PakFile::readEntry(const std::string& filename, std::vector<uint8_t>& data, bool decrypt) const {
+    // 取得条目数据并复制
+    PakEntryView view;
+    if (!getEntryView(filename, view)) {
         return false;
     }
+    data.assign(view.data(), view.data() + view.size());
     
     // 如果需要解密
     if (decrypt) {
-        // 根据文件类型选择解密方法
-        if (filename.find(".dat") != std::string::npos) {
-            // DAT文件使用EAGLS加密
-            encryption::EaglsEncryption enc;
-            data = enc.decrypt(data);
-        } else if (filename.find(".gr") != std::string::npos) {
-            // GR文件使用Lehmer加密
-            encryption::LehmerEncryption enc;
-            data = enc.decrypt(data);
-        }
+        decryptEntry(filename, data);
     }
     
+    return true;
+}
+
+void PakFile::decryptEntry(const std::string& filename, std::vector<uint8_t>& data) const {
+    // 根据文件类型选择解密方法
+    if (filename.find(".dat") != std::string::npos) {
+        // DAT文件使用EAGLS加密
+        encryption::EaglsEncryption enc(m_profile);
+        enc.decryptInPlace(data.data(), data.size());
+    } else if (filename.find(".gr") != std::string::npos) {
+        // GR文件使用Lehmer加密
+        encryption::LehmerEncryption enc(m_profile);
+        enc.decryptInPlace(data.data(), data.size());
+    }
+}
+
+bool PakFile::writeEntry(const std::string& filename, const std::string& outputPath,
+                         const std::vector<uint8_t>& data) const {
     // 构造输出文件路径
     std::string outputFilename = FileUtils::combinePath(outputPath, filename);
     
@@ -140,8 +231,29 @@ bool PakFile::extractFile(const std::string& filename, const std::string& output
     return true;
 }
 
-bool PakFile::extractAllFiles(const std::string& outputPath, bool decrypt) {
-    if (!m_isOpen) {
+bool PakFile::extractFile(const std::string& filename, const std::string& outputPath, bool decrypt) {
+    // 读取文件数据
+    std::vector<uint8_t> data;
+    if (!readEntry(filename, data, decrypt)) {
+        return false;
+    }
+    
+    return writeEntry(filename, outputPath, data);
+}
+
+void PakFile::setThreadCount(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    m_threadCount = threadCount > 0 ? threadCount : 1;
+}
+
+void PakFile::setMaxPendingBytes(size_t maxPendingBytes) {
+    m_maxPendingBytes = maxPendingBytes;
+}
+
+bool PakFile::extractAllFiles(const std::string& outputPath, bool decrypt, std::vector<PakExtractResult>* report) {
+    if (!m_isOpen || !m_data) {
         std::cerr << "Error: PAK file is not open" << std::endl;
         return false;
     }
@@ -152,16 +264,113 @@ bool PakFile::extractAllFiles(const std::string& outputPath, bool decrypt) {
         return false;
     }
     
-    bool success = true;
+    // 结果按条目序号存放，与完成顺序无关
+    std::vector<PakExtractResult> results(m_entries.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+        results[i].name = m_entries.getName(i);
+        results[i].success = false;
+    }
+    
+    // 读出的条目排队等待工作线程解密和写入
+    struct Job {
+        uint32_t index;
+        PakEntryView view;
+    };
+    std::deque<Job> queue;
+    std::mutex mutex;
+    std::condition_variable queueReady;     // 队列非空或读取结束
+    std::condition_variable spaceReady;     // 未写完的数据减少
+    size_t pendingBytes = 0;
+    bool readDone = false;
+    
+    auto worker = [&]() {
+        std::vector<uint8_t> data;
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queueReady.wait(lock, [&] { return !queue.empty() || readDone; });
+                if (queue.empty()) {
+                    return;
+                }
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            
+            PakExtractResult& result = results[job.index];
+            data.assign(job.view.data(), job.view.data() + job.view.size());
+            const size_t jobBytes = job.view.size();
+            job.view = PakEntryView();
+            
+            if (decrypt) {
+                decryptEntry(result.name, data);
+            }
+            if (writeEntry(result.name, outputPath, data)) {
+                result.success = true;
+            } else {
+                result.error = "write failed";
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pendingBytes -= jobBytes;
+            }
+            spaceReady.notify_one();
+        }
+    };
+    
+    const size_t workerCount = std::max<size_t>(1, std::min<size_t>(m_threadCount, m_entries.size()));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    
+    // 按偏移顺序读取，超过上限时等待写入完成
+    for (uint32_t index : m_entries.getOffsetOrder()) {
+        const size_t size = m_entries.getSize(index);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceReady.wait(lock, [&] { return pendingBytes == 0 || pendingBytes + size <= m_maxPendingBytes; });
+            pendingBytes += size;
+        }
+        
+        Job job;
+        job.index = index;
+        if (!getEntryViewAt(index, job.view)) {
+            results[index].error = "read failed";
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingBytes -= size;
+            continue;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(job));
+        }
+        queueReady.notify_one();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readDone = true;
+    }
+    queueReady.notify_all();
+    for (auto& thread : workers) {
+        thread.join();
+    }
     
-    // 提取所有文件
-    for (const auto& entry : m_entries) {
-        if (!extractFile(entry.first, outputPath, decrypt)) {
-            std::cerr << "Error: Failed to extract file: " << entry.first << std::endl;
+    bool success = true;
+    for (const auto& result : results) {
+        if (!result.success) {
+            std::cerr << "Error: Failed to extract file: " << result.name << std::endl;
             success = false;
         }
     }
     
+    if (report) {
+        *report = std::move(results);
+    }
+    
     return success;
 }
 
@@ -183,58 +392,46 @@ bool PakFile::create(const std::string& pakFilename, const std::vector<std::stri
     }
     
     // 创建索引文件名
-    std::string idxFilename = pakFilename;
-    size_t extPos = idxFilename.rfind('.');
-    if (extPos != std::string::npos) {
-        idxFilename = idxFilename.substr(0, extPos);
-    }
-    idxFilename += ".idx";
+    const std::string idxFilename = getIndexFilename(pakFilename);
     
-    // 初始化条目映射
-    std::map<std::string, PakEntry> entries;
+    // 初始化条目表
+    PakEntryTable entries(m_profile.indexNameSize, m_caseInsensitive);
+    entries.reserve(files.size());
     
-    // 写入文件数据
-    uint64_t offset = DATA_OFFSET;
+    // 逐个文件分块读取、加密、写入
+    uint64_t offset = m_profile.pakDataOffset;
+    detail::ChunkWriter writer(pakFile);
     
     for (const auto& filename : files) {
-        // 读取文件数据
-        std::vector<uint8_t> data = FileUtils::readFile(filename);
-        if (data.empty()) {
+        // 检查文件大小
+        const uint64_t fileSize = FileUtils::getFileSize(filename);
+        if (fileSize == 0 || fileSize > UINT32_MAX) {
             std::cerr << "Error: Failed to read file: " << filename << std::endl;
             continue;
         }
         
-        // 如果需要加密
-        if (encrypt) {
-            // 根据文件类型选择加密方法
-            if (filename.find(".dat") != std::string::npos) {
-                // DAT文件使用EAGLS加密
-                encryption::EaglsEncryption enc;
-                data = enc.encrypt(data);
-            } else if (filename.find(".gr") != std::string::npos) {
-                // GR文件使用Lehmer加密
-                encryption::LehmerEncryption enc;
-                data = enc.encrypt(data);
-            }
+        // 添加到条目表
+        const std::string name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
+        if (entries.add(name, offset, static_cast<uint32_t>(fileSize), 0) == PakEntryTable::NPOS) {
+            std::cerr << "Error: Invalid or duplicate file name: " << name << std::endl;
+            continue;
         }
         
-        // 创建条目
-        PakEntry entry;
-        entry.name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
-        entry.offset = offset;
-        entry.size = data.size();
-        entry.flags = 0;
-        
-        // 添加到条目映射
-        entries[entry.name] = entry;
-        
-        // 写入文件数据
-        pakFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+        // 已写入部分数据后无法跳过这个文件
+        if (!detail::appendFile(filename, fileSize, m_profile, encrypt, writer)) {
+            std::cerr << "Error: Failed to read file: " << filename << std::endl;
+            writer.finish();
+            return false;
+        }
         
         // 更新偏移
-        offset += data.size();
+        offset += fileSize;
     }
     
+    if (!writer.finish()) {
+        std::cerr << "Error: Failed to write PAK file: " << pakFilename << std::endl;
+        return false;
+    }
     pakFile.close();
     
     // 写入索引文件
@@ -245,6 +442,13 @@ bool PakFile::create(const std::string& pakFilename, const std::vector<std::stri
     
     m_pakFilename = pakFilename;
     m_entries = entries;
+    m_entries.sortByOffset();
+    
+    // 打开新建的PAK文件数据
+    if (!openData(true)) {
+        return false;
+    }
+    
     m_isOpen = true;
     
     return true;
@@ -267,48 +471,33 @@ bool PakFile::addFile(const std::string& pakFilename, const std::string& filenam
         return false;
     }
     
-    // 读取文件数据
-    std::vector<uint8_t> data = FileUtils::readFile(filename);
-    if (data.empty()) {
+    // 检查文件大小
+    const uint64_t fileSize = FileUtils::getFileSize(filename);
+    if (fileSize == 0 || fileSize > UINT32_MAX) {
         std::cerr << "Error: Failed to read file: " << filename << std::endl;
         return false;
     }
     
-    // 如果需要加密
-    if (encrypt) {
-        // 根据文件类型选择加密方法
-        if (filename.find(".dat") != std::string::npos) {
-            // DAT文件使用EAGLS加密
-            encryption::EaglsEncryption enc;
-            data = enc.encrypt(data);
-        } else if (filename.find(".gr") != std::string::npos) {
-            // GR文件使用Lehmer加密
-            encryption::LehmerEncryption enc;
-            data = enc.encrypt(data);
-        }
-    }
-    
-    // 创建条目
-    PakEntry entry;
-    entry.name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
-    
     // 检查文件是否已存在
-    auto it = m_entries.find(entry.name);
-    if (it != m_entries.end()) {
-        std::cerr << "Error: File already exists in PAK: " << entry.name << std::endl;
+    const std::string name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
+    if (m_entries.find(name) != PakEntryTable::NPOS) {
+        std::cerr << "Error: File already exists in PAK: " << name << std::endl;
         return false;
     }
     
     // 获取PAK文件大小
     size_t pakSize = FileUtils::getFileSize(pakFilename);
     
-    // 设置条目信息
-    entry.offset = pakSize;
-    entry.size = data.size();
-    entry.flags = 0;
+    // 添加到条目表
+    if (m_entries.add(name, pakSize + m_profile.pakDataOffset, static_cast<uint32_t>(fileSize), 0) ==
+        PakEntryTable::NPOS) {
+        std::cerr << "Error: Invalid file name: " << name << std::endl;
+        return false;
+    }
+    m_entries.sortByOffset();
     
-    // 添加到条目映射
-    m_entries[entry.name] = entry;
+    // 追加前释放映射，写入完成后重新打开
+    m_data.reset();
     
     // 打开PAK文件进行追加
     std::ofstream pakFile(pakFilename, std::ios::binary | std::ios::app);
@@ -317,17 +506,17 @@ bool PakFile::addFile(const std::string& pakFilename, const std::string& filenam
         return false;
     }
     
-    // 写入文件数据
-    pakFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+    // 分块读取、加密、追加
+    detail::ChunkWriter writer(pakFile);
+    const bool appended = detail::appendFile(filename, fileSize, m_profile, encrypt, writer);
+    if (!writer.finish() || !appended) {
+        std::cerr << "Error: Failed to append file to PAK: " << filename << std::endl;
+        return false;
+    }
     pakFile.close();
     
     // 构造索引文件名
-    std::string idxFilename = pakFilename;
-    size_t extPos = idxFilename.rfind('.');
-    if (extPos != std::string::npos) {
-        idxFilename = idxFilename.substr(0, extPos);
-    }
-    idxFilename += ".idx";
+    const std::string idxFilename = getIndexFilename(pakFilename);
     
     // 写入索引文件
     if (!writeIndex(idxFilename, m_entries)) {
@@ -335,98 +524,356 @@ bool PakFile::addFile(const std::string& pakFilename, const std::string& filenam
         return false;
     }
     
-    return true;
+    return openData(true);
+}
+
+bool PakFile::patchFiles(const std::string& pakFilename, const std::vector<std::string>& files, bool encrypt,
+                         std::vector<PakPatchResult>* report) {
+    // 打开PAK文件，读取索引
+    if (!open(pakFilename)) {
+        std::cerr << "Error: Failed to open PAK file: " << pakFilename << std::endl;
+        return false;
+    }
+    
+    // 写入前释放映射，完成后重新打开
+    m_data.reset();
+    
+    // 不截断地打开PAK文件
+    std::ofstream pakFile(pakFilename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!pakFile) {
+        std::cerr << "Error: Cannot open PAK file for writing: " << pakFilename << std::endl;
+        openData(true);
+        return false;
+    }
+    
+    uint64_t pakSize = FileUtils::getFileSize(pakFilename);
+    std::vector<PakPatchResult> results;
+    std::vector<uint32_t> changed;
+    bool success = true;
+    
+    for (const auto& filename : files) {
+        PakPatchResult result;
+        result.name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
+        result.success = false;
+        result.inPlace = false;
+        result.freedBytes = 0;
+        
+        // 只替换已有的条目
+        const uint32_t index = m_entries.find(result.name);
+        const uint64_t fileSize = FileUtils::getFileSize(filename);
+        if (index == PakEntryTable::NPOS) {
+            std::cerr << "Error: File not found in PAK: " << result.name << std::endl;
+        } else if (m_records[index] == PakEntryTable::NPOS) {
+            std::cerr << "Error: File has no index record: " << result.name << std::endl;
+        } else if (fileSize == 0 || fileSize > UINT32_MAX) {
+            std::cerr << "Error: Failed to read file: " << filename << std::endl;
+        } else if (m_entries.getOffset(index) < m_profile.pakDataOffset ||
+                   m_entries.getOffset(index) - m_profile.pakDataOffset > pakSize ||
+                   m_entries.getSize(index) > pakSize - (m_entries.getOffset(index) - m_profile.pakDataOffset)) {
+            // 索引损坏或密钥配置不对时不写入，避免覆盖其他位置
+            std::cerr << "Error: Invalid file offset in PAK: " << result.name << std::endl;
+        } else {
+            // 放得下时覆盖原位置，否则追加到末尾，原位置成为空闲空间
+            const uint32_t oldSize = m_entries.getSize(index);
+            uint64_t position = m_entries.getOffset(index) - m_profile.pakDataOffset;
+            if (fileSize <= oldSize) {
+                result.inPlace = true;
+                result.freedBytes = oldSize - fileSize;
+            } else {
+                position = pakSize;
+                result.freedBytes = oldSize;
+            }
+            
+            pakFile.clear();
+            pakFile.seekp(position);
+            detail::ChunkWriter writer(pakFile);
+            const bool written = detail::appendFile(filename, fileSize, m_profile, encrypt, writer);
+            if (writer.finish() && written) {
+                if (!result.inPlace) {
+                    pakSize += fileSize;
+                }
+                m_entries.setLocation(index, position + m_profile.pakDataOffset, static_cast<uint32_t>(fileSize));
+                changed.push_back(index);
+                result.success = true;
+            } else {
+                std::cerr << "Error: Failed to write file to PAK: " << filename << std::endl;
+            }
+        }
+        
+        success = success && result.success;
+        results.push_back(result);
+    }
+    
+    pakFile.close();
+    m_entries.sortByOffset();
+    
+    // 只重写改动的索引记录
+    if (!changed.empty() && !writeRecords(getIndexFilename(pakFilename), changed)) {
+        std::cerr << "Error: Failed to update index file: " << getIndexFilename(pakFilename) << std::endl;
+        success = false;
+    }
+    
+    if (report) {
+        *report = std::move(results);
+    }
+    
+    return openData(true) && success;
+}
+
+bool PakFile::compact(const std::string& pakFilename, const std::string& outputFilename, PakCompactOrder order,
+                      PakCompactResult* result) {
+    // 打开PAK文件，读取索引
+    if (!open(pakFilename)) {
+        std::cerr << "Error: Failed to open PAK file: " << pakFilename << std::endl;
+        return false;
+    }
+    
+    // 输出到原PAK（或共用同一个索引）时先写临时文件；同一个文件可能写成不同的路径，按文件比较
+    const auto sameFile = [](const std::string& a, const std::string& b) {
+        std::error_code ec;
+        if (std::filesystem::exists(b, ec)) {
+            return std::filesystem::equivalent(a, b, ec);
+        }
+        return std::filesystem::weakly_canonical(a, ec) == std::filesystem::weakly_canonical(b, ec);
+    };
+    const std::string targetPak = outputFilename.empty() ? pakFilename : outputFilename;
+    const std::string targetIdx = getIndexFilename(targetPak);
+    const bool inPlace = sameFile(pakFilename, targetPak) || sameFile(getIndexFilename(pakFilename), targetIdx);
+    const std::string tempPak = inPlace ? targetPak + ".tmp" : targetPak;
+    const std::string tempIdx = inPlace ? targetIdx + ".tmp" : targetIdx;
+    
+    // 条目顺序
+    std::vector<uint32_t> indices;
+    if (order == PakCompactOrder::Name) {
+        indices = m_entries.getNameOrder();
+    } else if (order == PakCompactOrder::Index) {
+        indices.resize(m_entries.size());
+        std::iota(indices.begin(), indices.end(), 0u);
+    } else {
+        indices = m_entries.getOffsetOrder();
+    }
+    
+    detail::RangeCopier copier;
+    if (!copier.open(pakFilename, tempPak)) {
+        std::cerr << "Error: Cannot create PAK file: " << tempPak << std::endl;
+        return false;
+    }
+    
+    // 依次复制条目数据，记录新的位置
+    const uint64_t pakSize = m_data->size();
+    PakEntryTable entries = m_entries;
+    uint64_t position = 0;
+    bool success = true;
+    for (uint32_t index : indices) {
+        const uint64_t offset = m_entries.getOffset(index);
+        const uint32_t size = m_entries.getSize(index);
+        if (offset < m_profile.pakDataOffset || offset - m_profile.pakDataOffset > pakSize ||
+            size > pakSize - (offset - m_profile.pakDataOffset)) {
+            std::cerr << "Error: Entry outside PAK file: " << m_entries.getName(index) << std::endl;
+            success = false;
+            break;
+        }
+        if (!copier.copy(offset - m_profile.pakDataOffset, size)) {
+            std::cerr << "Error: Failed to copy entry: " << m_entries.getName(index) << std::endl;
+            success = false;
+            break;
+        }
+        entries.setLocation(index, position + m_profile.pakDataOffset, size);
+        position += size;
+    }
+    const uint64_t kernelBytes = copier.getKernelBytes();
+    if (!copier.close()) {
+        std::cerr << "Error: Failed to write PAK file: " << tempPak << std::endl;
+        success = false;
+    }
+    
+    if (success && !writeIndex(tempIdx, entries)) {
+        std::cerr << "Error: Failed to write index file: " << tempIdx << std::endl;
+        success = false;
+    }
+    
+    // 失败时原PAK和索引没有改动，删除写了一半的输出
+    if (!success) {
+        std::remove(tempPak.c_str());
+        std::remove(tempIdx.c_str());
+        return false;
+    }
+    
+    // 释放映射后替换原文件；两次重命名之间中断时，新索引仍留在临时文件中
+    close();
+    if (inPlace) {
+        std::error_code ec;
+        std::filesystem::rename(tempPak, targetPak, ec);
+        if (ec) {
+            std::cerr << "Error: Failed to replace PAK file: " << targetPak << " - " << ec.message() << std::endl;
+            std::remove(tempPak.c_str());
+            std::remove(tempIdx.c_str());
+            return false;
+        }
+        std::filesystem::rename(tempIdx, targetIdx, ec);
+        if (ec) {
+            // 新PAK已经替换，原索引与它不再配对
+            std::cerr << "Error: Failed to replace index file: " << targetIdx << " - " << ec.message() << std::endl;
+            std::cerr << "The new index is in " << tempIdx << "; rename it to " << targetIdx
+                      << " by hand before using the PAK" << std::endl;
+            return false;
+        }
+    }
+    
+    if (result) {
+        result->entryCount = static_cast<uint32_t>(entries.size());
+        result->originalSize = pakSize;
+        result->compactedSize = position;
+        result->reclaimedBytes = pakSize > position ? pakSize - position : 0;
+        result->kernelBytes = kernelBytes;
+    }
+    
+    return open(targetPak);
+}
+
+std::string PakFile::getIndexFilename(const std::string& pakFilename) {
+    std::string idxFilename = pakFilename;
+    size_t extPos = idxFilename.rfind('.');
+    if (extPos != std::string::npos) {
+        idxFilename = idxFilename.substr(0, extPos);
+    }
+    return idxFilename + ".idx";
 }
 
 bool PakFile::readIndex(const std::string& idxFilename) {
+    const size_t indexSize = m_profile.indexSize;
+    const size_t entrySize = m_profile.indexEntrySize;
+    const size_t nameSize = m_profile.indexNameSize;
+    
     // 读取索引文件
     std::vector<uint8_t> indexData = FileUtils::readFile(idxFilename);
-    if (indexData.empty() || indexData.size() != INDEX_SIZE) {
+    if (indexData.empty() || indexData.size() != indexSize) {
         std::cerr << "Error: Invalid index file size: " << idxFilename << std::endl;
         return false;
     }
     
-    // 解密索引
-    encryption::CRuntimeRandomGenerator rng;
-    rng.srand(*reinterpret_cast<uint32_t*>(&indexData[INDEX_SIZE - 4]));
-    
-    std::vector<uint8_t> decryptedIndex(INDEX_SIZE - 4);
-    for (size_t i = 0; i < INDEX_SIZE - 4; ++i) {
-        decryptedIndex[i] = indexData[i] ^ INDEX_KEY[rng.rand() % INDEX_KEY.size()];
-    }
+    // 解密索引，尾部4字节是种子
+    std::memcpy(&m_indexSeed, &indexData[indexSize - 4], sizeof(m_indexSeed));
+    encryption::IndexEncryption enc(m_profile);
+    enc.decryptInPlace(indexData.data(), indexSize);
     
     // 解析索引
-    m_entries.clear();
-    
-    for (size_t i = 0; i < (INDEX_SIZE - 4) / ENTRY_SIZE; ++i) {
-        size_t offset = i * ENTRY_SIZE;
+    const size_t maxEntries = (indexSize - 4) / entrySize;
+    m_entries.reset(nameSize, m_caseInsensitive);
+    m_entries.reserve(maxEntries);
+    m_records.clear();
+    m_records.reserve(maxEntries);
+    
+    for (size_t i = 0; i < maxEntries; ++i) {
+        size_t offset = i * entrySize;
         
         // 检查是否到达索引末尾
-        if (decryptedIndex[offset] == 0) {
+        if (indexData[offset] == 0) {
             break;
         }
         
-        // 读取文件名
-        char name[NAME_SIZE + 1] = {0};
-        std::memcpy(name, &decryptedIndex[offset], NAME_SIZE);
-        
         // 读取条目信息
-        PakEntry entry;
-        entry.name = name;
-        entry.offset = *reinterpret_cast<uint64_t*>(&decryptedIndex[offset + NAME_SIZE]);
-        entry.size = *reinterpret_cast<uint32_t*>(&decryptedIndex[offset + NAME_SIZE + 8]);
-        entry.flags = *reinterpret_cast<uint32_t*>(&decryptedIndex[offset + NAME_SIZE + 12]);
+        const char* name = reinterpret_cast<const char*>(&indexData[offset]);
+        uint64_t entryOffset;
+        uint32_t entrySize32;
+        uint32_t entryFlags;
+        std::memcpy(&entryOffset, &indexData[offset + nameSize], sizeof(entryOffset));
+        std::memcpy(&entrySize32, &indexData[offset + nameSize + 8], sizeof(entrySize32));
+        std::memcpy(&entryFlags, &indexData[offset + nameSize + 12], sizeof(entryFlags));
         
-        // 添加到条目映射
-        m_entries[entry.name] = entry;
+        // 添加到条目表，重名时保留第一条
+        const size_t nameLength = strnlen(name, nameSize);
+        if (m_entries.add(name, nameLength, entryOffset, entrySize32, entryFlags) == PakEntryTable::NPOS) {
+            std::cerr << "Warning: Duplicate file name in index: " << std::string(name, nameLength) << std::endl;
+            continue;
+        }
+        m_records.push_back(static_cast<uint32_t>(i));
     }
     
+    m_entries.sortByOffset();
+    
     return true;
 }
 
-bool PakFile::writeIndex(const std::string& idxFilename, const std::map<std::string, PakEntry>& entries) {
+bool PakFile::writeIndex(const std::string& idxFilename, const PakEntryTable& entries) {
+    const size_t indexSize = m_profile.indexSize;
+    const size_t entrySize = m_profile.indexEntrySize;
+    const size_t nameSize = m_profile.indexNameSize;
+    
     // 创建索引数据
-    std::vector<uint8_t> indexData(INDEX_SIZE, 0);
+    std::vector<uint8_t> indexData(indexSize, 0);
     
-    // 写入条目
+    // 按文件名顺序写入条目，同时记下每个条目所在的记录
     size_t entryCount = 0;
-    for (const auto& entry : entries) {
-        if (entryCount >= (INDEX_SIZE - 4) / ENTRY_SIZE) {
+    m_records.assign(entries.size(), PakEntryTable::NPOS);
+    for (uint32_t index : entries.getNameOrder()) {
+        if (entryCount >= (indexSize - 4) / entrySize) {
             std::cerr << "Warning: Too many entries, some will be omitted" << std::endl;
             break;
         }
+        m_records[index] = static_cast<uint32_t>(entryCount);
         
-        size_t offset = entryCount * ENTRY_SIZE;
+        size_t offset = entryCount * entrySize;
+        const uint64_t entryOffset = entries.getOffset(index);
+        const uint32_t entrySize32 = entries.getSize(index);
+        const uint32_t entryFlags = entries.getFlags(index);
         
-        // 写入文件名
-        std::memcpy(&indexData[offset], entry.first.c_str(), std::min(entry.first.size(), NAME_SIZE));
+        // 写入文件名（定长字段）
+        std::memcpy(&indexData[offset], entries.getNameField(index), std::min(entries.getNameSize(), nameSize));
         
         // 写入条目信息
-        *reinterpret_cast<uint64_t*>(&indexData[offset + NAME_SIZE]) = entry.second.offset;
-        *reinterpret_cast<uint32_t*>(&indexData[offset + NAME_SIZE + 8]) = entry.second.size;
-        *reinterpret_cast<uint32_t*>(&indexData[offset + NAME_SIZE + 12]) = entry.second.flags;
+        std::memcpy(&indexData[offset + nameSize], &entryOffset, sizeof(entryOffset));
+        std::memcpy(&indexData[offset + nameSize + 8], &entrySize32, sizeof(entrySize32));
+        std::memcpy(&indexData[offset + nameSize + 12], &entryFlags, sizeof(entryFlags));
         
         entryCount++;
     }
     
     // 设置索引尾部标记
-    indexData[INDEX_SIZE - 4] = 0x60;
+    indexData[indexSize - 4] = 0x60;
+    std::memcpy(&m_indexSeed, &indexData[indexSize - 4], sizeof(m_indexSeed));
+    
+    // 加密索引（尾部4字节不加密）
+    encryption::IndexEncryption enc(m_profile);
+    enc.encryptInPlace(indexData.data(), indexSize);
     
-    // 加密索引
-    encryption::CRuntimeRandomGenerator rng;
-    rng.srand(*reinterpret_cast<uint32_t*>(&indexData[INDEX_SIZE - 4]));
+    // 写入索引文件
+    return FileUtils::writeFile(idxFilename, indexData);
+}
+
+bool PakFile::writeRecords(const std::string& idxFilename, const std::vector<uint32_t>& indices) {
+    const size_t entrySize = m_profile.indexEntrySize;
+    const size_t nameSize = m_profile.indexNameSize;
     
-    std::vector<uint8_t> encryptedIndex(INDEX_SIZE);
-    for (size_t i = 0; i < INDEX_SIZE - 4; ++i) {
-        encryptedIndex[i] = indexData[i] ^ INDEX_KEY[rng.rand() % INDEX_KEY.size()];
+    // 不截断地打开索引文件
+    std::ofstream idxFile(idxFilename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!idxFile) {
+        return false;
     }
     
-    // 复制尾部4字节
-    std::memcpy(&encryptedIndex[INDEX_SIZE - 4], &indexData[INDEX_SIZE - 4], 4);
+    encryption::IndexEncryption enc(m_profile);
+    std::vector<uint8_t> record(entrySize);
     
-    // 写入索引文件
-    return FileUtils::writeFile(idxFilename, encryptedIndex);
+    for (uint32_t index : indices) {
+        const size_t offset = static_cast<size_t>(m_records[index]) * entrySize;
+        const uint64_t entryOffset = m_entries.getOffset(index);
+        const uint32_t entrySize32 = m_entries.getSize(index);
+        const uint32_t entryFlags = m_entries.getFlags(index);
+        
+        // 组装记录
+        std::fill(record.begin(), record.end(), 0);
+        std::memcpy(record.data(), m_entries.getNameField(index), std::min(m_entries.getNameSize(), nameSize));
+        std::memcpy(&record[nameSize], &entryOffset, sizeof(entryOffset));
+        std::memcpy(&record[nameSize + 8], &entrySize32, sizeof(entrySize32));
+        std::memcpy(&record[nameSize + 12], &entryFlags, sizeof(entryFlags));
+        
+        // 按记录在索引中的位置加密后覆盖
+        enc.decryptRange(record.data(), offset, entrySize, m_indexSeed);
+        idxFile.seekp(offset);
+        idxFile.write(reinterpret_cast<const char*>(record.data()), entrySize);
+    }
+    
+    return idxFile.good();
 }
-
 } // namespace file
 } // namespace eagls
\ No newline at end of file
@@ -0,0 +1,125 @@
+﻿#include "pak_stream.h"
+#include "core/encryption/eagls_encryption.h"
+#include <algorithm>
+
+namespace eagls {
+namespace file {
+namespace detail {
+
+ChunkWriter::ChunkWriter(std::ofstream& out) : m_out(out), m_chunkCount(0), m_stop(false) {
+    m_thread = std::thread(&ChunkWriter::run, this);
+}
+
+ChunkWriter::~ChunkWriter() {
+    finish();
+}
+
+std::vector<uint8_t> ChunkWriter::acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_chunkReady.wait(lock, [this] { return !m_free.empty() || m_chunkCount < STREAM_MAX_CHUNKS; });
+    if (!m_free.empty()) {
+        std::vector<uint8_t> chunk = std::move(m_free.back());
+        m_free.pop_back();
+        return chunk;
+    }
+    m_chunkCount++;
+    std::vector<uint8_t> chunk;
+    chunk.reserve(STREAM_CHUNK_SIZE);
+    return chunk;
+}
+
+void ChunkWriter::submit(std::vector<uint8_t> chunk) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(chunk));
+    }
+    m_queueReady.notify_one();
+}
+
+void ChunkWriter::release(std::vector<uint8_t> chunk) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(std::move(chunk));
+    }
+    m_chunkReady.notify_one();
+}
+
+bool ChunkWriter::finish() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_queueReady.notify_one();
+        m_thread.join();
+    }
+    return m_out.good();
+}
+
+void ChunkWriter::run() {
+    for (;;) {
+        std::vector<uint8_t> chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueReady.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+            if (m_queue.empty()) {
+                return;
+            }
+            chunk = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        
+        m_out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+        release(std::move(chunk));
+    }
+}
+
+bool appendFile(const std::string& filename, uint64_t fileSize, const encryption::KeyProfile& profile,
+                bool encrypt, ChunkWriter& writer) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    
+    const bool isDat = encrypt && filename.find(".dat") != std::string::npos;
+    const bool isGr = encrypt && !isDat && filename.find(".gr") != std::string::npos;
+    
+    // 读取尾部的种子
+    uint8_t seed = 0;
+    if ((isDat || isGr) && fileSize > 0) {
+        file.seekg(fileSize - 1);
+        file.read(reinterpret_cast<char*>(&seed), 1);
+        file.seekg(0);
+        if (!file) {
+            return false;
+        }
+    }
+    
+    encryption::EaglsEncryption datEnc(profile);
+    encryption::LehmerEncryption grEnc(profile);
+    
+    for (uint64_t position = 0; position < fileSize;) {
+        const size_t size = static_cast<size_t>(std::min<uint64_t>(STREAM_CHUNK_SIZE, fileSize - position));
+        std::vector<uint8_t> chunk = writer.acquire();
+        chunk.resize(size);
+        if (!file.read(reinterpret_cast<char*>(chunk.data()), size)) {
+            writer.release(std::move(chunk));
+            return false;
+        }
+        
+        if (isDat) {
+            datEnc.decryptRange(chunk.data(), position, size, fileSize, seed);
+        } else if (isGr) {
+            grEnc.decryptRange(chunk.data(), position, size, fileSize, seed);
+        }
+        
+        writer.submit(std::move(chunk));
+        position += size;
+    }
+    
+    return true;
+}
+
+} // namespace detail
+} // namespace file
+} // namespace eagls
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+#include "core/encryption/key_profile.h"
+
+namespace eagls {
+namespace file {
+namespace detail {
+
+// 打包时每次读写的块大小
+constexpr size_t STREAM_CHUNK_SIZE = 1024 * 1024;
+
+// 打包时最多同时存在的块数：一块在读、一块排队、一块在写
+constexpr size_t STREAM_MAX_CHUNKS = 3;
+
+/**
+ * @brief 后台写入线程（PakFile和pak_packer共用）
+ *
+ * 调用线程读取和加密下一块时，上一块在后台写入。块缓冲区循环使用，
+ * 内存占用最多为STREAM_MAX_CHUNKS块，与文件大小无关。
+ * 从输出流的当前位置开始顺序写入，结束前调用者不能再操作输出流。
+ */
+class ChunkWriter {
+public:
+    explicit ChunkWriter(std::ofstream& out);
+    ~ChunkWriter();
+
+    ChunkWriter(const ChunkWriter&) = delete;
+    ChunkWriter& operator=(const ChunkWriter&) = delete;
+
+    /**
+     * @brief 取得一块空闲缓冲区，块数达到上限时等待写入完成
+     */
+    std::vector<uint8_t> acquire();
+
+    /**
+     * @brief 交给后台写入
+     */
+    void submit(std::vector<uint8_t> chunk);
+
+    /**
+     * @brief 归还未写入的缓冲区
+     */
+    void release(std::vector<uint8_t> chunk);
+
+    /**
+     * @brief 等待全部写完并结束后台线程
+     * @return 是否全部写入成功
+     */
+    bool finish();
+
+private:
+    void run();
+
+    std::ofstream& m_out;                           // 输出文件
+    std::thread m_thread;                           // 写入线程
+    std::mutex m_mutex;
+    std::condition_variable m_queueReady;           // 有块待写或要求结束
+    std::condition_variable m_chunkReady;           // 有空闲缓冲区
+    std::deque<std::vector<uint8_t>> m_queue;       // 待写的块
+    std::vector<std::vector<uint8_t>> m_free;       // 空闲缓冲区
+    size_t m_chunkCount;                            // 已分配的块数
+    bool m_stop;                                    // 是否要求结束
+};
+
+/**
+ * @brief 分块读取文件，按需加密后交给写入线程
+ *
+ * GR只加密开头lehmerLimit字节，DAT从文本偏移起隔字节加密，两者的种子都是文件最后一个字节，
+ * 先单独读出种子，之后每块按其在文件中的位置加密，不需要整个文件在内存中。
+ * @param filename 文件名
+ * @param fileSize 文件大小
+ * @param profile 密钥配置
+ * @param encrypt 是否加密
+ * @param writer 写入线程
+ * @return 是否成功
+ */
+bool appendFile(const std::string& filename, uint64_t fileSize, const encryption::KeyProfile& profile,
+                bool encrypt, ChunkWriter& writer);
+
+} // namespace detail
+} // namespace file
+} // namespace eagls
@@ -0,0 +1,266 @@
+﻿#include "core/file/pak_transaction.h"
+#include "core/file/file_utils.h"
+#include "pak_stream.h"
+#include <filesystem>
+#include <iostream>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+namespace eagls {
+namespace file {
+
+PakTransaction::PakTransaction() : m_originalSize(0), m_tail(0), m_active(false) {
+}
+
+PakTransaction::~PakTransaction() {
+    rollback();
+}
+
+void PakTransaction::setProfile(const encryption::KeyProfile& profile) {
+    m_pak.setProfile(profile);
+}
+
+bool PakTransaction::begin(const std::string& pakFilename) {
+    rollback();
+    
+    // 只需要索引
+    if (!m_pak.open(pakFilename, false)) {
+        std::cerr << "Error: Failed to open PAK file: " << pakFilename << std::endl;
+        return false;
+    }
+    
+    // 释放只读句柄，否则Windows上无法再以写方式打开或截断PAK
+    m_pak.m_data.reset();
+    
+    m_originalSize = FileUtils::getFileSize(pakFilename);
+    m_tail = m_originalSize;
+    
+    // 不截断地打开，新数据写在原末尾之后
+    m_pakOut.open(pakFilename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!m_pakOut) {
+        std::cerr << "Error: Cannot open PAK file for writing: " << pakFilename << std::endl;
+        m_pak.close();
+        return false;
+    }
+    
+    m_pakFilename = pakFilename;
+    m_entries = m_pak.m_entries;
+    m_removed.assign(m_entries.size(), false);
+    m_active = true;
+    
+    return true;
+}
+
+bool PakTransaction::add(const std::string& filename, bool encrypt) {
+    if (!m_active) {
+        std::cerr << "Error: No active PAK transaction" << std::endl;
+        return false;
+    }
+    
+    // 已删除的同名条目视为替换
+    const std::string name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
+    const uint32_t index = m_entries.find(name);
+    if (index != PakEntryTable::NPOS && !m_removed[index]) {
+        std::cerr << "Error: File already exists in PAK: " << name << std::endl;
+        return false;
+    }
+    if (index == PakEntryTable::NPOS && !m_entries.isValidName(name)) {
+        std::cerr << "Error: Invalid file name: " << name << std::endl;
+        return false;
+    }
+    
+    uint64_t offset;
+    uint32_t size;
+    if (!stage(filename, encrypt, offset, size)) {
+        return false;
+    }
+    
+    if (index != PakEntryTable::NPOS) {
+        m_entries.setLocation(index, offset, size);
+        m_removed[index] = false;
+    } else if (m_entries.add(name, offset, size, 0) != PakEntryTable::NPOS) {
+        m_removed.push_back(false);
+    } else {
+        // 不会进入索引，退回写入位置，数据在下次写入或提交时被覆盖、截掉
+        std::cerr << "Error: Failed to add entry: " << name << std::endl;
+        m_tail -= size;
+        return false;
+    }
+    
+    return true;
+}
+
+bool PakTransaction::replace(const std::string& filename, bool encrypt) {
+    if (!m_active) {
+        std::cerr << "Error: No active PAK transaction" << std::endl;
+        return false;
+    }
+    
+    const std::string name = FileUtils::getFileName(filename) + FileUtils::getFileExtension(filename);
+    const uint32_t index = m_entries.find(name);
+    if (index == PakEntryTable::NPOS || m_removed[index]) {
+        std::cerr << "Error: File not found in PAK: " << name << std::endl;
+        return false;
+    }
+    
+    uint64_t offset;
+    uint32_t size;
+    if (!stage(filename, encrypt, offset, size)) {
+        return false;
+    }
+    
+    m_entries.setLocation(index, offset, size);
+    return true;
+}
+
+bool PakTransaction::remove(const std::string& name) {
+    if (!m_active) {
+        std::cerr << "Error: No active PAK transaction" << std::endl;
+        return false;
+    }
+    
+    const uint32_t index = m_entries.find(name);
+    if (index == PakEntryTable::NPOS || m_removed[index]) {
+        std::cerr << "Error: File not found in PAK: " << name << std::endl;
+        return false;
+    }
+    
+    m_removed[index] = true;
+    return true;
+}
+
+bool PakTransaction::stage(const std::string& filename, bool encrypt, uint64_t& offset, uint32_t& size) {
+    const uint64_t fileSize = FileUtils::getFileSize(filename);
+    if (fileSize == 0 || fileSize > UINT32_MAX) {
+        std::cerr << "Error: Failed to read file: " << filename << std::endl;
+        return false;
+    }
+    
+    // commit失败时输出流已关闭，重新打开
+    if (!m_pakOut.is_open()) {
+        m_pakOut.open(m_pakFilename, std::ios::binary | std::ios::in | std::ios::out);
+        if (!m_pakOut) {
+            std::cerr << "Error: Cannot open PAK file for writing: " << m_pakFilename << std::endl;
+            return false;
+        }
+    }
+    
+    // 写到上一个新数据之后，失败时下一次写入覆盖这部分
+    const encryption::KeyProfile& profile = m_pak.getProfile();
+    m_pakOut.clear();
+    m_pakOut.seekp(m_tail);
+    detail::ChunkWriter writer(m_pakOut);
+    const bool written = detail::appendFile(filename, fileSize, profile, encrypt, writer);
+    if (!writer.finish() || !written) {
+        std::cerr << "Error: Failed to append file to PAK: " << filename << std::endl;
+        return false;
+    }
+    
+    offset = m_tail + profile.pakDataOffset;
+    size = static_cast<uint32_t>(fileSize);
+    m_tail += fileSize;
+    return true;
+}
+
+bool PakTransaction::commit() {
+    if (!m_active) {
+        std::cerr << "Error: No active PAK transaction" << std::endl;
+        return false;
+    }
+    
+    // 确保新数据全部写入PAK之后才替换索引，之前失败的写入留下的错误状态不算
+    m_pakOut.clear();
+    m_pakOut.close();
+    if (m_pakOut.fail()) {
+        std::cerr << "Error: Failed to write PAK file: " << m_pakFilename << std::endl;
+        return false;
+    }
+    
+    // 去掉最后一次失败的写入留下的数据
+    std::error_code ec;
+    if (FileUtils::getFileSize(m_pakFilename) != m_tail) {
+        fs::resize_file(m_pakFilename, m_tail, ec);
+        if (ec) {
+            std::cerr << "Error: Failed to truncate PAK file: " << m_pakFilename << " - " << ec.message() << std::endl;
+            return false;
+        }
+    }
+    
+    // 去掉已删除的条目
+    PakEntryTable entries(m_entries.getNameSize(), m_entries.isCaseInsensitive());
+    entries.reserve(m_entries.size());
+    for (uint32_t i = 0; i < m_entries.size(); ++i) {
+        if (!m_removed[i]) {
+            entries.add(m_entries.getName(i), m_entries.getOffset(i), m_entries.getSize(i), m_entries.getFlags(i));
+        }
+    }
+    
+    const encryption::KeyProfile& profile = m_pak.getProfile();
+    if (entries.size() > (profile.indexSize - 4) / profile.indexEntrySize) {
+        std::cerr << "Error: Too many entries for the index: " << entries.size() << std::endl;
+        return false;
+    }
+    
+    // 新数据先落盘，断电后新索引不会指向尚未写入的数据
+    if (!FileUtils::syncFile(m_pakFilename)) {
+        return false;
+    }
+    
+    // 写入临时索引并落盘，再重命名覆盖原索引
+    const std::string idxFilename = PakFile::getIndexFilename(m_pakFilename);
+    const std::string tempFilename = idxFilename + ".tmp";
+    if (!m_pak.writeIndex(tempFilename, entries) || !FileUtils::syncFile(tempFilename)) {
+        std::cerr << "Error: Failed to write index file: " << tempFilename << std::endl;
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+    
+    fs::rename(tempFilename, idxFilename, ec);
+    if (ec) {
+        std::cerr << "Error: Failed to replace index file: " << idxFilename << " - " << ec.message() << std::endl;
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+    
+    // 让重命名本身落盘；失败时断电后只会退回原索引，与PAK仍然配对
+    const fs::path idxDirectory = fs::absolute(idxFilename, ec).parent_path();
+    if (!ec) {
+        FileUtils::syncFile(idxDirectory.string());
+    }
+    
+    m_pak.close();
+    m_entries.clear();
+    m_removed.clear();
+    m_active = false;
+    
+    return true;
+}
+
+void PakTransaction::rollback() {
+    if (!m_active) {
+        return;
+    }
+    
+    // 原索引没有改变，截掉新写入的数据即可（包括失败的写入）
+    m_pakOut.close();
+    if (FileUtils::getFileSize(m_pakFilename) != m_originalSize) {
+        std::error_code ec;
+        fs::resize_file(m_pakFilename, m_originalSize, ec);
+        if (ec) {
+            std::cerr << "Warning: Failed to truncate PAK file: " << m_pakFilename << " - " << ec.message() << std::endl;
+        }
+    }
+    
+    m_pak.close();
+    m_entries.clear();
+    m_removed.clear();
+    m_active = false;
+}
+
+bool PakTransaction::isActive() const {
+    return m_active;
+}
+
+} // namespace file
+} // namespace eagls
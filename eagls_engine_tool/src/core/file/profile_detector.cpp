@@ -0,0 +1,193 @@
+﻿#include "core/file/profile_detector.h"
+#include "core/file/file_utils.h"
+#include "core/file/pak_file.h"
+#include "core/encryption/eagls_encryption.h"
+#include "core/compression/gr_lzss.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace eagls {
+namespace file {
+
+namespace {
+
+/**
+ * @brief 一条记录在PAK文件中的数据区间
+ */
+struct Extent {
+    uint64_t begin;
+    uint64_t end;
+};
+
+bool isPrintableName(const char* name, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char c = static_cast<unsigned char>(name[i]);
+        if (c < 0x20 || c > 0x7e) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isGrName(const char* name, size_t length) {
+    if (length < 3) {
+        return false;
+    }
+    const char* ext = name + length - 3;
+    return ext[0] == '.' && (ext[1] == 'g' || ext[1] == 'G') && (ext[2] == 'r' || ext[2] == 'R');
+}
+
+ProfileProbe reject(ProfileProbe result, const std::string& reason) {
+    result.matched = false;
+    result.reason = reason;
+    return result;
+}
+
+} // namespace
+
+ProfileProbe ProfileDetector::probe(const std::string& pakFilename, const encryption::KeyProfile& profile) {
+    ProfileProbe result;
+    result.profileName = profile.name;
+    result.matched = false;
+    result.recordsChecked = 0;
+    result.imageChecked = false;
+
+    if (!profile.isValid()) {
+        return reject(result, "invalid profile");
+    }
+
+    // 检查索引大小
+    std::ifstream idxFile(PakFile::getIndexFilename(pakFilename), std::ios::binary | std::ios::ate);
+    if (!idxFile) {
+        return reject(result, "cannot open index file");
+    }
+    if (static_cast<size_t>(idxFile.tellg()) != profile.indexSize) {
+        return reject(result, "index size mismatch");
+    }
+    const uint64_t pakSize = FileUtils::getFileSize(pakFilename);
+
+    // 只读取开头的若干条记录和尾部的种子
+    const size_t recordCount = std::min(PROBE_RECORDS, (profile.indexSize - 4) / profile.indexEntrySize);
+    std::vector<uint8_t> records(recordCount * profile.indexEntrySize);
+    uint32_t seed = 0;
+    idxFile.seekg(profile.indexSize - 4);
+    idxFile.read(reinterpret_cast<char*>(&seed), sizeof(seed));
+    idxFile.seekg(0);
+    idxFile.read(reinterpret_cast<char*>(records.data()), records.size());
+    if (!idxFile) {
+        return reject(result, "cannot read index file");
+    }
+
+    encryption::IndexEncryption indexEnc(profile);
+    indexEnc.decryptRange(records.data(), 0, records.size(), seed);
+
+    // 检查记录是否合理
+    std::vector<Extent> extents;
+    const Extent* sample = nullptr;
+    size_t sampleIndex = 0;
+    for (size_t i = 0; i < recordCount; ++i) {
+        const uint8_t* record = &records[i * profile.indexEntrySize];
+        const char* name = reinterpret_cast<const char*>(record);
+        const size_t nameLength = strnlen(name, profile.indexNameSize);
+        if (nameLength == 0) {
+            break;
+        }
+        if (!isPrintableName(name, nameLength)) {
+            return reject(result, "unprintable file name");
+        }
+
+        uint64_t offset;
+        uint32_t size;
+        std::memcpy(&offset, record + profile.indexNameSize, sizeof(offset));
+        std::memcpy(&size, record + profile.indexNameSize + 8, sizeof(size));
+        if (offset < profile.pakDataOffset || offset - profile.pakDataOffset > pakSize ||
+            size > pakSize - (offset - profile.pakDataOffset)) {
+            return reject(result, "entry outside PAK file");
+        }
+
+        extents.push_back({offset - profile.pakDataOffset, offset - profile.pakDataOffset + size});
+        if (sampleIndex == 0 && size > 1 && isGrName(name, nameLength)) {
+            sampleIndex = extents.size();
+        }
+        result.recordsChecked++;
+    }
+    if (extents.empty()) {
+        return reject(result, "empty index");
+    }
+    if (sampleIndex != 0) {
+        sample = &extents[sampleIndex - 1];
+    }
+
+    // 打包工具按顺序写入，偏移递增；按名称排序写出的索引偏移不一定递增，因此排序后检查区间不重叠
+    std::vector<Extent> sorted = extents;
+    std::sort(sorted.begin(), sorted.end(), [](const Extent& a, const Extent& b) { return a.begin < b.begin; });
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        if (sorted[i].begin < sorted[i - 1].end) {
+            return reject(result, "overlapping entries");
+        }
+    }
+
+    // 解密GR样本的开头，解压出BMP标记
+    if (sample) {
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(sample->end - sample->begin - 1, SAMPLE_SIZE));
+        std::vector<uint8_t> head(length + 1);
+
+        std::ifstream pakFile(pakFilename, std::ios::binary);
+        pakFile.seekg(sample->begin);
+        pakFile.read(reinterpret_cast<char*>(head.data()), length);
+        pakFile.seekg(sample->end - 1);
+        pakFile.read(reinterpret_cast<char*>(&head[length]), 1);
+        if (!pakFile) {
+            return reject(result, "cannot read GR sample");
+        }
+
+        // 种子是整个文件的最后一个字节，拼在样本后面即可按完整文件解密开头部分
+        encryption::LehmerEncryption grEnc(profile);
+        grEnc.decryptInPlace(head.data(), head.size());
+
+        uint8_t magic[2];
+        if (compression::GrLzss::decodeInto(head.data(), length, magic, sizeof(magic)) != sizeof(magic) ||
+            magic[0] != 'B' || magic[1] != 'M') {
+            return reject(result, "GR sample is not a BMP");
+        }
+        result.imageChecked = true;
+    }
+
+    result.matched = true;
+    return result;
+}
+
+bool ProfileDetector::detect(const std::string& pakFilename, encryption::KeyProfile& profile,
+                             std::vector<ProfileProbe>* report) {
+    if (report) {
+        report->clear();
+    }
+
+    const std::vector<encryption::KeyProfile> profiles = encryption::KeyProfileRegistry::getProfiles();
+    const encryption::KeyProfile* best = nullptr;
+    bool bestImageChecked = false;
+
+    for (const auto& candidate : profiles) {
+        ProfileProbe result = probe(pakFilename, candidate);
+        if (result.matched && (!best || (result.imageChecked && !bestImageChecked))) {
+            best = &candidate;
+            bestImageChecked = result.imageChecked;
+        }
+        if (report) {
+            report->push_back(result);
+        }
+    }
+
+    if (!best) {
+        std::cerr << "Error: No key profile matches PAK file: " << pakFilename << std::endl;
+        return false;
+    }
+
+    profile = *best;
+    return true;
+}
+
+} // namespace file
+} // namespace eagls
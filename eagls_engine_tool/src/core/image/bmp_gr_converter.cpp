@@ -1,6 +1,6 @@
 ﻿#include "core/image/bmp_gr_converter.h"
 #include "core/file/file_utils.h"
-#include "core/compression/lzss.h"
+#include "core/compression/gr_lzss.h"
 #include "core/encryption/eagls_encryption.h"
 #include <fstream>
 #include <iostream>
@@ -35,13 +35,14 @@ struct BitmapInfoHeader {
 };
 #pragma pack(pop)
 
-BmpGrConverter::BmpGrConverter() {
+BmpGrConverter::BmpGrConverter() : m_lastStats{0, 0, 0.0} {
 }
 
 BmpGrConverter::~BmpGrConverter() {
 }
 
-bool BmpGrConverter::bmpToGr(const std::string& bmpFilename, const std::string& grFilename) {
+bool BmpGrConverter::bmpToGr(const std::string& bmpFilename, const std::string& grFilename,
+                             compression::GrLevel level) {
     // 读取BMP文件
     int width, height, bpp;
     std::vector<uint8_t> bmpData = readBmp(bmpFilename, width, height, bpp);
@@ -51,32 +52,64 @@ bool BmpGrConverter::bmpToGr(const std::string& bmpFilename, const std::string&
     }
     
     // 压缩BMP数据
-    compression::LZSS lzss(7);  // 使用7位前向缓冲区
+    compression::GrLzss lzss;
+    lzss.setLevel(level);
     std::vector<uint8_t> compressedData = lzss.encode(bmpData);
+    m_lastStats = lzss.getLastStats();
     
-    // 加密压缩后的数据
+    // 原地加密压缩后的数据
     encryption::LehmerEncryption enc;
-    std::vector<uint8_t> encryptedData = enc.encrypt(compressedData);
+    enc.encryptInPlace(compressedData.data(), compressedData.size());
     
     // 写入GR文件
-    return writeGr(grFilename, encryptedData);
+    return writeGr(grFilename, compressedData);
 }
 
 bool BmpGrConverter::grToBmp(const std::string& grFilename, const std::string& bmpFilename) {
     // 读取GR文件
-    std::vector<uint8_t> encryptedData = readGr(grFilename);
-    if (encryptedData.empty()) {
+    std::vector<uint8_t> compressedData = readGr(grFilename);
+    if (compressedData.empty()) {
         std::cerr << "Error: Failed to read GR file: " << grFilename << std::endl;
         return false;
     }
     
-    // 解密数据
-    encryption::LehmerEncryption enc;
-    std::vector<uint8_t> compressedData = enc.decrypt(encryptedData);
+    // 边解密边解压
+    std::vector<uint8_t> bmpData;
+    if (!decodeGr(compressedData.data(), compressedData.size(), bmpData)) {
+        return false;
+    }
     
-    // 解压数据
-    compression::LZSS lzss(7);  // 使用7位前向缓冲区
-    std::vector<uint8_t> bmpData = lzss.decode(compressedData);
+    // 写入BMP文件
+    return file::FileUtils::writeFile(bmpFilename, bmpData);
+}
+
+size_t BmpGrConverter::decodeGr(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize,
+                                const encryption::KeyProfile& profile) {
+    if (size == 0) {
+        return 0;
+    }
+    
+    // 最后一个字节是种子，加密部分为开头的min(size - 1, lehmerLimit)字节
+    encryption::LehmerEncryption enc(profile);
+    encryption::KeystreamCache::Keystream stream = enc.getKeystream(data[size - 1]);
+    const size_t keySize = std::min(size - 1, stream->size());
+    
+    return compression::GrLzss::decodeInto(data, size, stream->data(), keySize, output, outputSize);
+}
+
+bool BmpGrConverter::decodeGr(const uint8_t* data, size_t size, std::vector<uint8_t>& bmpData,
+                              const encryption::KeyProfile& profile) {
+    bmpData.clear();
+    if (size == 0) {
+        std::cerr << "Error: Empty GR data" << std::endl;
+        return false;
+    }
+    
+    // 求出解压后的大小
+    encryption::LehmerEncryption enc(profile);
+    encryption::KeystreamCache::Keystream stream = enc.getKeystream(data[size - 1]);
+    const size_t keySize = std::min(size - 1, stream->size());
+    bmpData.resize(compression::GrLzss::getDecodedSize(data, size, stream->data(), keySize));
     
     // 检查解压后的数据是否为有效的BMP
     if (bmpData.size() < sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader)) {
@@ -84,21 +117,21 @@ bool BmpGrConverter::grToBmp(const std::string& grFilename, const std::string& b
         return false;
     }
     
-    // 从解压后的数据中提取BMP信息
-    BitmapFileHeader* fileHeader = reinterpret_cast<BitmapFileHeader*>(bmpData.data());
-    BitmapInfoHeader* infoHeader = reinterpret_cast<BitmapInfoHeader*>(bmpData.data() + sizeof(BitmapFileHeader));
+    // 直接解压到结果中
+    compression::GrLzss::decodeInto(data, size, stream->data(), keySize, bmpData.data(), bmpData.size());
     
     // 检查BMP头
+    const BitmapFileHeader* fileHeader = reinterpret_cast<const BitmapFileHeader*>(bmpData.data());
     if (fileHeader->bfType != 0x4D42) {  // "BM"
         std::cerr << "Error: Invalid BMP signature" << std::endl;
         return false;
     }
     
-    // 写入BMP文件
-    return file::FileUtils::writeFile(bmpFilename, bmpData);
+    return true;
 }
 
-int BmpGrConverter::batchBmpToGr(const std::string& inputDir, const std::string& outputDir) {
+int BmpGrConverter::batchBmpToGr(const std::string& inputDir, const std::string& outputDir,
+                                 compression::GrLevel level) {
     // 确保输出目录存在
     if (!file::FileUtils::createDirectory(outputDir)) {
         std::cerr << "Error: Failed to create output directory: " << outputDir << std::endl;
@@ -124,9 +157,11 @@ int BmpGrConverter::batchBmpToGr(const std::string& inputDir, const std::string&
         );
         
         // 转换文件
-        if (bmpToGr(file, outputFilename)) {
+        if (bmpToGr(file, outputFilename, level)) {
             count++;
-            std::cout << "Converted: " << file << " -> " << outputFilename << std::endl;
+            std::cout << "Converted: " << file << " -> " << outputFilename
+                      << " (" << m_lastStats.inputSize << " -> " << m_lastStats.outputSize << " bytes, "
+                      << m_lastStats.elapsedMs << " ms)" << std::endl;
         }
     }
     
@@ -168,6 +203,10 @@ int BmpGrConverter::batchGrToBmp(const std::string& inputDir, const std::string&
     return count;
 }
 
+compression::GrEncodeStats BmpGrConverter::getLastStats() const {
+    return m_lastStats;
+}
+
 std::vector<uint8_t> BmpGrConverter::readBmp(const std::string& filename, int& width, int& height, int& bpp) {
     // 读取BMP文件
     std::vector<uint8_t> data = file::FileUtils::readFile(filename);
@@ -1,7 +1,7 @@
 ﻿#include "core/image/image_utils.h"
 #include "core/image/png_bmp_converter.h"
 #include "core/file/file_utils.h"
-#include "core/compression/lzss.h"
+#include "core/compression/gr_lzss.h"
 #include "core/encryption/eagls_encryption.h"
 #include <fstream>
 #include <iostream>
@@ -39,6 +39,9 @@ struct BitmapInfoHeader {
 };
 #pragma pack(pop)
 
+// 解出BMP头时读取的GR开头字节数（54字节的头全是原始数据时也只需61字节）
+constexpr size_t GR_HEADER_SAMPLE = 256;
+
 ImageInfo ImageUtils::getBmpInfo(const std::string& filename) {
     ImageInfo info = {0};
 
@@ -84,20 +87,36 @@ ImageInfo ImageUtils::getBmpInfo(const std::string& filename) {
 ImageInfo ImageUtils::getGrInfo(const std::string& filename) {
     ImageInfo info = {0};
 
-    // 读取GR文件
-    std::vector<uint8_t> data = file::FileUtils::readFile(filename);
-    if (data.empty()) {
+    // 只读取GR文件开头足以解出BMP头的部分和最后一个字节（种子）
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Error: Failed to read GR file: " << filename << std::endl;
+        return info;
+    }
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize == 0) {
         std::cerr << "Error: Failed to read GR file: " << filename << std::endl;
         return info;
     }
 
-    // 解密数据
-    encryption::LehmerEncryption enc;
-    std::vector<uint8_t> compressedData = enc.decrypt(data);
+    std::vector<uint8_t> head(std::min(fileSize, GR_HEADER_SAMPLE));
+    uint8_t seed = 0;
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(head.data()), head.size());
+    file.seekg(fileSize - 1);
+    file.read(reinterpret_cast<char*>(&seed), 1);
+    if (!file) {
+        std::cerr << "Error: Failed to read GR file: " << filename << std::endl;
+        return info;
+    }
 
-    // 解压数据
-    compression::LZSS lzss(7);  // 使用7位前向缓冲区
-    std::vector<uint8_t> bmpData = lzss.decode(compressedData);
+    // 边解密边解压，只解出BMP头
+    encryption::LehmerEncryption enc;
+    encryption::KeystreamCache::Keystream stream = enc.getKeystream(seed);
+    const size_t keySize = std::min({fileSize - 1, stream->size(), head.size()});
+    std::vector<uint8_t> bmpData(sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader));
+    bmpData.resize(compression::GrLzss::decodeInto(head.data(), head.size(), stream->data(), keySize,
+                                                   bmpData.data(), bmpData.size()));
 
     // 检查解压后的数据是否为有效的BMP
     if (bmpData.size() < sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader)) {
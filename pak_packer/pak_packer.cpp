@@ -5,118 +5,84 @@
 #include <cstring>
 #include <cstdint>
 #include <filesystem>
+#include "core/encryption/eagls_cipher.h"
+#include "core/encryption/key_profile.h"
+#include "pak_stream.h"
 
-const char* IndexKey = "1qaz2wsx3edc4rfv5tgb6yhn7ujm8ik,9ol.0p;/-@:^[]";
-const char* EaglsKey = "EAGLS_SYSTEM";
+// 索引文件大小
+constexpr size_t INDEX_SIZE = 0x61a84;
 
-class CRuntimeRandomGenerator {
-public:
-    void srand(int32_t seed) {
-        m_seed = seed;
-    }
-
-    int16_t rand() {
-        m_seed = m_seed * 214013 + 2531011;
-        return (int16_t)(m_seed >> 16) & 0x7FFF;
-    }
-
-private:
-    uint32_t m_seed = 0;
-};
-
-class LehmerRandomGenerator {
-public:
-    LehmerRandomGenerator() : m_seed(0) {}
-
-    void srand(int32_t seed) {
-        m_seed = seed ^ 123459876;
-    }
-
-    int32_t rand() {
-        m_seed = (48271 * (m_seed % 44488) - 3399 * (m_seed / 44488));
-        if (m_seed < 0) {
-            m_seed += 2147483647;
-        }
-        return m_seed * 4.656612875245797e-10 * 256;
-    }
-
-private:
-    int32_t m_seed;
-};
+// 索引中每条记录的大小（文件名0x18字节 + 偏移8字节 + 大小4字节 + 保留4字节）
+constexpr size_t INDEX_ENTRY_SIZE = 0x28;
 
 void DecryptIndex(std::vector<uint8_t>& data) {
-    CRuntimeRandomGenerator rng;
-    rng.srand(*reinterpret_cast<const uint32_t*>(data.data() + data.size() - 4));
-    size_t len_IndexKey = strlen(IndexKey);
-    for (size_t i = 0; i < data.size() - 4; ++i) {
-        data[i] ^= IndexKey[rng.rand() % len_IndexKey];
-    }
+    uint32_t seed = *reinterpret_cast<const uint32_t*>(data.data() + data.size() - 4);
+    eagls::encryption::cipher::IndexCipher::apply(data.data(), data.size() - 4, seed);
 }
 
-void DecryptCg(std::vector<unsigned char>& data) {
-    LehmerRandomGenerator rng;
-    rng.srand(data.back());
-    size_t limit = data.size() - 1;
-    if (limit > 0x174b)
-        limit = 0x174b;
-    for (size_t i = 0; i < limit; ++i) {
-        data[i] ^= EaglsKey[rng.rand() % 12];
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "用法: " << argv[0] << " <输入目录> <pak文件路径> [加密=0]" << std::endl;
+        return 1;
     }
-}
 
-void DecryptDat(std::vector<uint8_t>& data) {
-    CRuntimeRandomGenerator rng;
-    int text_offset = 3600;
-    int text_length = data.size() - text_offset - 2;
-    rng.srand((int8_t)data[data.size() - 1]);  // 使用数据的最后一个字节作为随机数生成器的种子
-    for (int i = 0; i < text_length; i += 2) {
-        data[text_offset + i] ^= EaglsKey[rng.rand() % 12];
+    std::string folder = argv[1];
+    std::string pak_path = argv[2];
+    std::vector<uint8_t> idx(INDEX_SIZE, 0);
+    size_t entry_count = 0;
+    uint64_t pak_size = 0;
+    uint64_t offset = 0x174b;
+    bool encrypt = false;
+    if (argc > 3 && std::string(argv[3]) == "1")
+        encrypt = true;
+
+    std::ofstream pak_file(pak_path, std::ios::binary);
+    if (!pak_file.is_open()) {
+        std::cerr << "无法创建pak文件: " << pak_path << std::endl;
+        return 1;
     }
-}
 
-int main(int argc, char* argv[]) {
-    std::string folder = argv[1];
-    std::vector<uint8_t> pack;
-    std::vector<uint8_t> idx;
-    uint32_t offset = 0x174b;
-    bool decrypt = false;
-    if (argc > 1 && argv[2] == "1")
-        decrypt = false;
-    for (const auto& entry : std::filesystem::directory_iterator(folder)) {
-        std::ifstream file(entry.path(), std::ios::binary);
-        if (file.is_open()) {
-            std::vector<unsigned char> buffer(std::istreambuf_iterator<char>(file), {});
+    // 逐个文件分块读取、加密、追加到pak文件，内存占用与pak大小无关
+    const eagls::encryption::KeyProfile profile = eagls::encryption::KeyProfileRegistry::getDefault();
+    {
+        eagls::file::detail::ChunkWriter writer(pak_file);
+        for (const auto& entry : std::filesystem::directory_iterator(folder)) {
+            if (!entry.is_regular_file())
+                continue;
             auto path = entry.path();
-            if (decrypt)
-            {
-                if (path.extension() == ".dat")
-                    DecryptDat(buffer);
-                else if (path.extension() == ".gr")
-                    DecryptCg(buffer);
-            }
             std::string filename = path.filename().string();
-            std::vector<uint8_t> tmp(filename.begin(), filename.end());
-            tmp.resize(0x18);
-            idx.insert(idx.end(), tmp.begin(), tmp.end());
-            uint64_t data1 = pack.size() + offset;
-            idx.insert(idx.end(), reinterpret_cast<const uint8_t*>(&data1), reinterpret_cast<const uint8_t*>(&data1) + sizeof(data1));
-            uint32_t data2 = buffer.size();
-            idx.insert(idx.end(), reinterpret_cast<const uint8_t*>(&data2), reinterpret_cast<const uint8_t*>(&data2) + sizeof(data2));
-            uint32_t data3 = 0;
-            idx.insert(idx.end(), reinterpret_cast<const uint8_t*>(&data3), reinterpret_cast<const uint8_t*>(&data3) + sizeof(data3));
-            file.seekg(0, 0);
-            pack.insert(pack.end(), buffer.begin(), buffer.end());
+            const uint64_t file_size = entry.file_size();
+            if (filename.size() > 0x18 || file_size > UINT32_MAX) {
+                std::cerr << "跳过文件（文件名过长或文件过大）: " << filename << std::endl;
+                continue;
+            }
+            if ((entry_count + 1) * INDEX_ENTRY_SIZE > INDEX_SIZE - 4) {
+                std::cerr << "文件过多，索引已满: " << filename << std::endl;
+                break;
+            }
+
+            if (!eagls::file::detail::appendFile(path.string(), file_size, profile, encrypt, writer)) {
+                std::cerr << "无法读取文件: " << path.string() << std::endl;
+                writer.finish();
+                return 1;
+            }
+
+            uint8_t* record = idx.data() + entry_count * INDEX_ENTRY_SIZE;
+            std::memcpy(record, filename.data(), filename.size());
+            uint64_t data1 = pak_size + offset;
+            std::memcpy(record + 0x18, &data1, sizeof(data1));
+            uint32_t data2 = static_cast<uint32_t>(file_size);
+            std::memcpy(record + 0x20, &data2, sizeof(data2));
+            entry_count++;
+            pak_size += file_size;
+        }
+        if (!writer.finish()) {
+            std::cerr << "写入pak文件失败: " << pak_path << std::endl;
+            return 1;
         }
-        file.close();
     }
-
-    std::string pak_path = argv[2];
-    std::ofstream pak_file(pak_path, std::ios::binary);
-    pak_file.write(reinterpret_cast<const char*>(pack.data()), pack.size());
     pak_file.close();
 
-    // idx.insert(idx.end(), 0, 0x61a84 - idx.size());
-    idx.resize(0x61a84);
     idx[idx.size() - 4] = 0x00;
     DecryptIndex(idx);
 
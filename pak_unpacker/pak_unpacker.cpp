@@ -5,9 +5,15 @@
 #include <cstring>
 #include <cstdint>
 #include <filesystem>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "core/encryption/eagls_cipher.h"
 
-const char* IndexKey = "1qaz2wsx3edc4rfv5tgb6yhn7ujm8ik,9ol.0p;/-@:^[]";
-const char* EaglsKey = "EAGLS_SYSTEM";
+// 已读出但尚未写完的数据上限
+constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
 
 // 文件描述结构体
 struct FileDesc {
@@ -17,115 +23,78 @@ struct FileDesc {
     uint32_t reserved;    // 保留字段
 };
 
-class CRuntimeRandomGenerator {
-public:
-    void srand(int32_t seed) {
-        m_seed = seed;
-    }
-
-    int16_t rand() {
-        m_seed = m_seed * 214013 + 2531011;
-        return (int16_t)(m_seed >> 16) & 0x7FFF;
-    }
-
-private:
-    uint32_t m_seed = 0;
-};
-
-class LehmerRandomGenerator {
-public:
-    LehmerRandomGenerator() : m_seed(0) {}
-
-    void srand(int32_t seed) {
-        m_seed = seed ^ 123459876;
-    }
-
-    int32_t rand() {
-        m_seed = (48271 * (m_seed % 44488) - 3399 * (m_seed / 44488));
-        if (m_seed < 0) {
-            m_seed += 2147483647;
-        }
-        // 使用static_cast明确转换，避免警告
-        return static_cast<int32_t>(m_seed * 4.656612875245797e-10 * 256);
-    }
-
-private:
-    int32_t m_seed;
+// 待提取的文件
+struct ExtractItem {
+    std::string filename;  // 文件名
+    uint64_t offset;       // 文件在pak中的偏移量
+    uint32_t size;         // 文件大小
+    bool success;          // 是否成功
+    std::string message;   // 处理结果
 };
 
 // 解密idx文件
 void DecryptIndex(std::vector<uint8_t>& data) {
-    CRuntimeRandomGenerator rng;
     // 使用idx文件末尾的4字节作为种子
     uint32_t seed = *reinterpret_cast<const uint32_t*>(data.data() + data.size() - 4);
-    rng.srand(seed);
-    size_t len_IndexKey = strlen(IndexKey);
 
     // 解密idx文件内容（除了最后4字节的种子）
-    for (size_t i = 0; i < data.size() - 4; ++i) {
-        data[i] ^= IndexKey[rng.rand() % len_IndexKey];
-    }
+    eagls::encryption::cipher::IndexCipher::apply(data.data(), data.size() - 4, seed);
 }
 
 // 解密CG文件
 void DecryptCg(std::vector<uint8_t>& data) {
-    LehmerRandomGenerator rng;
-    // 使用文件最后一个字节作为种子
-    rng.srand(data.back());
-    size_t limit = data.size() - 1;
-    if (limit > 0x174b)
-        limit = 0x174b;
-
-    // 解密文件内容
-    for (size_t i = 0; i < limit; ++i) {
-        data[i] ^= EaglsKey[rng.rand() % 12];
+    if (data.empty()) {
+        return;
     }
+    // 使用文件最后一个字节作为种子，最多解密开头0x174b字节
+    eagls::encryption::cipher::GrCipher::apply(data.data(), data.size() - 1,
+                                               eagls::encryption::cipher::grSeed(data.back()));
 }
 
 // 解密DAT文件
 void DecryptDat(std::vector<uint8_t>& data) {
-    CRuntimeRandomGenerator rng;
-    int text_offset = 3600;
-    // 使用static_cast明确转换size_t到int，避免警告
-    int text_length = static_cast<int>(data.size()) - text_offset - 2;
-
-    // 使用文件最后一个字节作为种子
-    rng.srand((int8_t)data[data.size() - 1]);
-
-    // 解密文件内容，每隔2字节解密一次
-    for (int i = 0; i < text_length; i += 2) {
-        data[text_offset + i] ^= EaglsKey[rng.rand() % 12];
+    if (data.size() < 2) {
+        return;
     }
+    // 使用文件最后一个字节作为种子，从偏移3600起每隔2字节解密一次
+    eagls::encryption::cipher::DatCipher::apply(data.data(), data.size() - 2,
+                                                eagls::encryption::cipher::datSeed(data.back()));
 }
 
-// 根据文件扩展名选择合适的解密方法
-void DecryptFile(std::vector<uint8_t>& data, const std::string& filename) {
+// 根据文件扩展名选择合适的解密方法，返回处理结果
+std::string DecryptFile(std::vector<uint8_t>& data, const std::string& filename) {
     std::string extension = filename.substr(filename.find_last_of(".") + 1);
 
     if (extension == "dat") {
         DecryptDat(data);
-        std::cout << "已解密DAT文件: " << filename << std::endl;
+        return "已解密DAT文件: " + filename;
     } else if (extension == "gr") {
         DecryptCg(data);
-        std::cout << "已解密GR文件: " << filename << std::endl;
-    } else {
-        std::cout << "未知文件类型，不进行解密: " << filename << std::endl;
+        return "已解密GR文件: " + filename;
     }
+    return "未知文件类型，不进行解密: " + filename;
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 3) {
-        std::cout << "用法: " << argv[0] << " <pak文件路径> <输出目录> [解密=1]" << std::endl;
+        std::cout << "用法: " << argv[0] << " <pak文件路径> <输出目录> [解密=1] [线程数=0]" << std::endl;
         return 1;
     }
 
     std::string pak_path = argv[1];
     std::string output_dir = argv[2];
     bool decrypt = true;
+    size_t thread_count = 0;
 
     if (argc > 3) {
         decrypt = (std::string(argv[3]) == "1");
     }
+    if (argc > 4) {
+        thread_count = static_cast<size_t>(std::max(0, std::atoi(argv[4])));
+    }
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
 
     // 确保输出目录存在
     std::filesystem::create_directories(output_dir);
@@ -143,6 +112,10 @@ int main(int argc, char* argv[]) {
     // 读取idx文件内容
     std::vector<uint8_t> idx_data((std::istreambuf_iterator<char>(idx_file)), std::istreambuf_iterator<char>());
     idx_file.close();
+    if (idx_data.size() < 4) {
+        std::cerr << "idx文件过小: " << idx_path << std::endl;
+        return 1;
+    }
 
     // 解密idx文件
     DecryptIndex(idx_data);
@@ -156,52 +129,146 @@ int main(int argc, char* argv[]) {
     }
 
     // 解析idx文件中的文件信息
-    size_t file_count = 0;
-    for (size_t i = 0; i < idx_data.size() - 4; i += sizeof(FileDesc)) {
-        FileDesc* file_desc = reinterpret_cast<FileDesc*>(idx_data.data() + i);
+    std::vector<ExtractItem> items;
+    for (size_t i = 0; i + sizeof(FileDesc) <= idx_data.size() - 4; i += sizeof(FileDesc)) {
+        FileDesc file_desc;
+        std::memcpy(&file_desc, idx_data.data() + i, sizeof(file_desc));
 
         // 检查文件名是否为空，如果是则跳过
-        if (file_desc->filename[0] == 0) {
+        if (file_desc.filename[0] == 0) {
             continue;
         }
 
-        std::string filename(file_desc->filename);
-        // 移除文件名中的空字符
-        filename = filename.c_str();
+        ExtractItem item;
+        item.filename.assign(file_desc.filename, strnlen(file_desc.filename, sizeof(file_desc.filename)));
+        item.offset = file_desc.offset;
+        item.size = file_desc.size;
+        item.success = false;
+        items.push_back(item);
+    }
 
-        if (filename.empty()) {
-            continue;
+    // 按偏移量顺序读取pak文件
+    std::vector<size_t> read_order(items.size());
+    for (size_t i = 0; i < read_order.size(); ++i) {
+        read_order[i] = i;
+    }
+    std::stable_sort(read_order.begin(), read_order.end(), [&](size_t a, size_t b) {
+        return items[a].offset < items[b].offset;
+    });
+
+    // 读取线程把文件内容放入队列，工作线程解密并保存
+    struct Job {
+        size_t index;
+        std::vector<uint8_t> data;
+    };
+    std::deque<Job> queue;
+    std::mutex mutex;
+    std::condition_variable queue_ready;
+    std::condition_variable space_ready;
+    size_t pending_bytes = 0;
+    bool read_done = false;
+
+    auto worker = [&]() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queue_ready.wait(lock, [&] { return !queue.empty() || read_done; });
+                if (queue.empty()) {
+                    return;
+                }
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            ExtractItem& item = items[job.index];
+            const size_t job_bytes = job.data.size();
+
+            // 如果需要解密，则解密文件
+            if (decrypt) {
+                item.message = DecryptFile(job.data, item.filename) + "\n";
+            }
+
+            // 保存文件
+            std::string output_path = output_dir + "/" + item.filename;
+            std::ofstream output_file(output_path, std::ios::binary);
+            if (output_file.is_open()) {
+                output_file.write(reinterpret_cast<const char*>(job.data.data()), job.data.size());
+                output_file.close();
+            }
+            if (output_file) {
+                item.success = true;
+                item.message += "已保存文件: " + output_path;
+            } else {
+                item.message += "无法创建输出文件: " + output_path;
+            }
+
+            job.data = std::vector<uint8_t>();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending_bytes -= job_bytes;
+            }
+            space_ready.notify_one();
         }
+    };
 
-        std::cout << "发现文件: " << filename << ", 偏移量: " << file_desc->offset << ", 大小: " << file_desc->size << std::endl;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(thread_count, std::max<size_t>(1, items.size())); ++i) {
+        workers.emplace_back(worker);
+    }
 
-        // 从pak文件中提取文件内容
-        std::vector<uint8_t> file_data(file_desc->size);
-        pak_file.seekg(file_desc->offset - 0x174b);  // 调整偏移量
-        pak_file.read(reinterpret_cast<char*>(file_data.data()), file_desc->size);
+    for (size_t index : read_order) {
+        ExtractItem& item = items[index];
 
-        // 如果需要解密，则解密文件
-        if (decrypt) {
-            DecryptFile(file_data, filename);
+        // 未写完的数据超过上限时等待
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            space_ready.wait(lock, [&] { return pending_bytes == 0 || pending_bytes + item.size <= MAX_PENDING_BYTES; });
+            pending_bytes += item.size;
         }
 
-        // 保存文件
-        std::string output_path = output_dir + "/" + filename;
-        std::ofstream output_file(output_path, std::ios::binary);
-        if (!output_file.is_open()) {
-            std::cerr << "无法创建输出文件: " << output_path << std::endl;
+        // 从pak文件中提取文件内容
+        Job job;
+        job.index = index;
+        job.data.resize(item.size);
+        pak_file.clear();
+        pak_file.seekg(item.offset - 0x174b);  // 调整偏移量
+        pak_file.read(reinterpret_cast<char*>(job.data.data()), item.size);
+        if (item.offset < 0x174b || !pak_file) {
+            item.message = "无法读取文件内容: " + item.filename;
+            std::lock_guard<std::mutex> lock(mutex);
+            pending_bytes -= item.size;
             continue;
         }
 
-        output_file.write(reinterpret_cast<const char*>(file_data.data()), file_data.size());
-        output_file.close();
-
-        std::cout << "已保存文件: " << output_path << std::endl;
-        file_count++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(job));
+        }
+        queue_ready.notify_one();
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        read_done = true;
+    }
+    queue_ready.notify_all();
+    for (auto& thread : workers) {
+        thread.join();
+    }
     pak_file.close();
+
+    // 按idx中的顺序输出结果
+    size_t file_count = 0;
+    for (const auto& item : items) {
+        std::cout << "发现文件: " << item.filename << ", 偏移量: " << item.offset << ", 大小: " << item.size << std::endl;
+        (item.success ? std::cout : std::cerr) << item.message << std::endl;
+        if (item.success) {
+            file_count++;
+        }
+    }
+
     std::cout << "解包完成，共提取了 " << file_count << " 个文件" << std::endl;
 
-    return 0;
+    return file_count == items.size() ? 0 : 1;
 }
@@ -19,7 +19,8 @@ class EaglsEncryption:
     def Decrypt(self, data):
         text_offset = 3600
         text_length = len(data) - text_offset - 2
-        self.m_rng.SRand(data[-1])
+        # 种子按有符号char扩展，与原版一致
+        self.m_rng.SRand(data[-1] - 256 if data[-1] >= 0x80 else data[-1])
         for i in range(0, text_length, 2):
             data[text_offset + i] ^= self.Key[self.m_rng.Rand() % len(self.Key)]
 
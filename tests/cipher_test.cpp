@@ -0,0 +1,304 @@
+﻿// 加密的回归测试：三种加密（模板、分块、运行时参数、引擎封装）的输出与冻结的向量比较。
+// 向量由重构前pak_unpacker中的DecryptCg/DecryptDat/DecryptIndex生成：
+// 输入为 data[i] = i * 131 + 17，尾部写入种子，加密后对整个缓冲区取FNV-1a 32位哈希。
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "core/encryption/eagls_cipher.h"
+#include "core/encryption/eagls_encryption.h"
+
+using namespace eagls::encryption;
+
+namespace {
+
+struct Vector {
+    size_t size;        // 数据大小（含尾部种子）
+    uint32_t seed;      // 种子（GR/DAT为最后一个字节，索引为尾部4字节）
+    uint32_t hash;      // 加密后整个缓冲区的FNV-1a哈希
+};
+
+const Vector GR_VECTORS[] = {
+    {1, 0x00, 0x050C5D1F},
+    {1, 0x45, 0xC00BF080},
+    {1, 0x7F, 0xFA0C4BCE},
+    {1, 0x80, 0x850B939F},
+    {1, 0xC5, 0x400B2700},
+    {1, 0xFF, 0x7A0B824E},
+    {2, 0x00, 0xC0EBD0D5},
+    {2, 0x45, 0x7BEB6436},
+    {2, 0x7F, 0x51EB2218},
+    {2, 0x80, 0x5CDC28DF},
+    {2, 0xC5, 0x97DC85C0},
+    {2, 0xFF, 0xD1DCE10E},
+    {3, 0x00, 0xFC4C97B0},
+    {3, 0x45, 0x414D044F},
+    {3, 0x7F, 0x5B69AF51},
+    {3, 0x80, 0x4858E6F4},
+    {3, 0xC5, 0x855946FB},
+    {3, 0xFF, 0x4F58F1F9},
+    {255, 0x00, 0x9FDBE5E2},
+    {255, 0x45, 0x4A6F3301},
+    {255, 0x7F, 0xB1C97CDB},
+    {255, 0x80, 0x4E2BD9A4},
+    {255, 0xC5, 0xAE726195},
+    {255, 0xFF, 0x6FEEF4A6},
+    {5963, 0x00, 0x100C8138},
+    {5963, 0x45, 0xA30E4087},
+    {5963, 0x7F, 0x51D04349},
+    {5963, 0x80, 0x2AD80ED9},
+    {5963, 0xC5, 0x53710717},
+    {5963, 0xFF, 0x7064F6F2},
+    {5964, 0x00, 0xD6140B12},
+    {5964, 0x45, 0xB06FF765},
+    {5964, 0x7F, 0x028B853B},
+    {5964, 0x80, 0xEEDE2771},
+    {5964, 0xC5, 0x7BF9FC21},
+    {5964, 0xFF, 0xFCC2959A},
+    {5965, 0x00, 0xE6C237B4},
+    {5965, 0x45, 0x0009E12F},
+    {5965, 0x7F, 0x4595FE19},
+    {5965, 0x80, 0xCD294C41},
+    {5965, 0xC5, 0x0CD5D0B3},
+    {5965, 0xFF, 0x4C728C02},
+    {9999, 0x00, 0x9CB7388B},
+    {9999, 0x45, 0xAD979420},
+    {9999, 0x7F, 0xB6132FC2},
+    {9999, 0x80, 0x91A771E2},
+    {9999, 0xC5, 0xBBD735EC},
+    {9999, 0xFF, 0x8C3D2E81},
+};
+
+const Vector DAT_VECTORS[] = {
+    {3601, 0x00, 0xC8F9421F},
+    {3601, 0x45, 0x83F8D580},
+    {3601, 0x7F, 0xBDF930CE},
+    {3601, 0x80, 0x48F8789F},
+    {3601, 0xC5, 0x03F80C00},
+    {3601, 0xFF, 0x3DF8674E},
+    {3602, 0x00, 0xD8C20224},
+    {3602, 0x45, 0x95C198AB},
+    {3602, 0x7F, 0xBFC1DAC9},
+    {3602, 0x80, 0x58C138A4},
+    {3602, 0xC5, 0x15C0CF2B},
+    {3602, 0xFF, 0x3FC11149},
+    {3603, 0x00, 0xEE5D9905},
+    {3603, 0x45, 0x253FC928},
+    {3603, 0x7F, 0xE98EC319},
+    {3603, 0x80, 0xF090FBEF},
+    {3603, 0xC5, 0x5F8F7CDB},
+    {3603, 0xFF, 0x6F403DA6},
+    {3604, 0x00, 0xB8E52440},
+    {3604, 0x45, 0xD46E3551},
+    {3604, 0x7F, 0x11AA11DA},
+    {3604, 0x80, 0x30975942},
+    {3604, 0xC5, 0x57A8ED0C},
+    {3604, 0xFF, 0x7A6F3AA3},
+    {3605, 0x00, 0x84189EDE},
+    {3605, 0x45, 0x61D3A698},
+    {3605, 0x7F, 0x8C5C6E05},
+    {3605, 0x80, 0xC881F8F3},
+    {3605, 0xC5, 0x8CD47A38},
+    {3605, 0xFF, 0x9C68C025},
+    {4097, 0x00, 0x843EBE0A},
+    {4097, 0x45, 0xD6A7CF70},
+    {4097, 0x7F, 0x82EEE28E},
+    {4097, 0x80, 0x0B8A8544},
+    {4097, 0xC5, 0xC841C852},
+    {4097, 0xFF, 0x63027ACA},
+    {12345, 0x00, 0x708B202A},
+    {12345, 0x45, 0xBDCEE28B},
+    {12345, 0x7F, 0x7E6A0B61},
+    {12345, 0x80, 0x6EED5553},
+    {12345, 0xC5, 0x16F0A05F},
+    {12345, 0xFF, 0x4098BC03},
+    {65536, 0x00, 0xF53BD5C7},
+    {65536, 0x45, 0x7AFD78AF},
+    {65536, 0x7F, 0x8C1DADD4},
+    {65536, 0x80, 0x84E3D7A2},
+    {65536, 0xC5, 0xAAC27BC3},
+    {65536, 0xFF, 0x47A13912},
+};
+
+const Vector INDEX_VECTORS[] = {
+    {5, 0x00000000, 0xA982960D},
+    {5, 0x00000060, 0x6FAD039D},
+    {5, 0x0000007F, 0x13E4FA3E},
+    {5, 0x00000080, 0x4CBBC5CA},
+    {5, 0x000000C5, 0x272B1F79},
+    {5, 0xFFFFFFFF, 0xC16D900A},
+    {5, 0x12345678, 0xC40E04F4},
+    {6, 0x00000000, 0xF381F14B},
+    {6, 0x00000060, 0x41ED9413},
+    {6, 0x0000007F, 0x1E9F3C9E},
+    {6, 0x00000080, 0x6EFEEBEA},
+    {6, 0x000000C5, 0xEBB2CF57},
+    {6, 0xFFFFFFFF, 0x8C8332F8},
+    {6, 0x12345678, 0x6C1DE920},
+    {1001, 0x00000000, 0x019128FF},
+    {1001, 0x00000060, 0xE7489D25},
+    {1001, 0x0000007F, 0x1789C12D},
+    {1001, 0x00000080, 0xEC5D24CA},
+    {1001, 0x000000C5, 0x81EFDFE1},
+    {1001, 0xFFFFFFFF, 0xC5D5BEC6},
+    {1001, 0x12345678, 0xE982CFCD},
+    {400004, 0x00000000, 0xEFF9D1EA},
+    {400004, 0x00000060, 0x5BEBA637},
+    {400004, 0x0000007F, 0x898D96D2},
+    {400004, 0x00000080, 0xF3BB0D61},
+    {400004, 0x000000C5, 0x6AAB3B3B},
+    {400004, 0xFFFFFFFF, 0x2DC007AA},
+    {400004, 0x12345678, 0x32CCB536},
+};
+
+// 分块加密时的块大小，取奇数使块边界落在奇偶两种位置
+constexpr size_t CHUNK = 777;
+
+int g_failures = 0;
+
+uint32_t fnv1a(const std::vector<uint8_t>& data) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t b : data) {
+        hash = (hash ^ b) * 16777619u;
+    }
+    return hash;
+}
+
+std::vector<uint8_t> makeInput(const Vector& v, size_t seedBytes) {
+    std::vector<uint8_t> data(v.size);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + 17);
+    }
+    std::memcpy(&data[v.size - seedBytes], &v.seed, seedBytes);
+    return data;
+}
+
+void check(const char* what, const Vector& v, const std::vector<uint8_t>& data) {
+    const uint32_t hash = fnv1a(data);
+    if (hash != v.hash) {
+        std::printf("FAIL %s size=%zu seed=0x%X: 0x%08X != 0x%08X\n", what, v.size, v.seed, hash, v.hash);
+        ++g_failures;
+    }
+}
+
+// 对每个块调用fn(chunk, position, size)
+template <class Fn>
+void forEachChunk(std::vector<uint8_t>& data, size_t end, Fn fn) {
+    for (size_t position = 0; position < end; position += CHUNK) {
+        fn(data.data() + position, position, std::min(CHUNK, end - position));
+    }
+}
+
+void testGr() {
+    cipher::RuntimeCipher<cipher::LehmerRng> runtime;
+    runtime.key = cipher::EAGLS_KEY;
+    runtime.keyLength = cipher::keyLength(cipher::EAGLS_KEY);
+    runtime.limit = 0x174b;
+
+    for (const Vector& v : GR_VECTORS) {
+        const uint32_t seed = cipher::grSeed(static_cast<uint8_t>(v.seed));
+
+        std::vector<uint8_t> data = makeInput(v, 1);
+        cipher::GrCipher::apply(data.data(), v.size - 1, seed);
+        check("GrCipher::apply", v, data);
+
+        data = makeInput(v, 1);
+        forEachChunk(data, v.size - 1, [&](uint8_t* chunk, size_t position, size_t size) {
+            cipher::GrCipher::applyRange(chunk, position, size, v.size - 1, seed);
+        });
+        check("GrCipher::applyRange", v, data);
+
+        data = makeInput(v, 1);
+        runtime.apply(data.data(), v.size - 1, seed);
+        check("RuntimeCipher<LehmerRng>", v, data);
+
+        data = makeInput(v, 1);
+        LehmerEncryption().encryptInPlace(data.data(), data.size());
+        check("LehmerEncryption::encryptInPlace", v, data);
+
+        data = makeInput(v, 1);
+        LehmerEncryption enc;
+        forEachChunk(data, v.size - 1, [&](uint8_t* chunk, size_t position, size_t size) {
+            enc.decryptRange(chunk, position, size, v.size, static_cast<uint8_t>(v.seed));
+        });
+        check("LehmerEncryption::decryptRange", v, data);
+    }
+}
+
+void testDat() {
+    cipher::RuntimeCipher<cipher::CRuntimeRng> runtime;
+    runtime.key = cipher::EAGLS_KEY;
+    runtime.keyLength = cipher::keyLength(cipher::EAGLS_KEY);
+    runtime.offset = 3600;
+    runtime.stride = 2;
+
+    for (const Vector& v : DAT_VECTORS) {
+        const uint32_t seed = cipher::datSeed(static_cast<uint8_t>(v.seed));
+
+        std::vector<uint8_t> data = makeInput(v, 1);
+        cipher::DatCipher::apply(data.data(), v.size - 2, seed);
+        check("DatCipher::apply", v, data);
+
+        data = makeInput(v, 1);
+        forEachChunk(data, v.size - 2, [&](uint8_t* chunk, size_t position, size_t size) {
+            cipher::DatCipher::applyRange(chunk, position, size, v.size - 2, seed);
+        });
+        check("DatCipher::applyRange", v, data);
+
+        data = makeInput(v, 1);
+        runtime.apply(data.data(), v.size - 2, seed);
+        check("RuntimeCipher<CRuntimeRng>", v, data);
+
+        data = makeInput(v, 1);
+        EaglsEncryption().encryptInPlace(data.data(), data.size());
+        check("EaglsEncryption::encryptInPlace", v, data);
+
+        data = makeInput(v, 1);
+        EaglsEncryption enc;
+        forEachChunk(data, v.size - 2, [&](uint8_t* chunk, size_t position, size_t size) {
+            enc.decryptRange(chunk, position, size, v.size, static_cast<uint8_t>(v.seed));
+        });
+        check("EaglsEncryption::decryptRange", v, data);
+    }
+}
+
+void testIndex() {
+    for (const Vector& v : INDEX_VECTORS) {
+        std::vector<uint8_t> data = makeInput(v, 4);
+        cipher::IndexCipher::apply(data.data(), v.size - 4, v.seed);
+        check("IndexCipher::apply", v, data);
+
+        data = makeInput(v, 4);
+        forEachChunk(data, v.size - 4, [&](uint8_t* chunk, size_t position, size_t size) {
+            cipher::IndexCipher::applyRange(chunk, position, size, v.size - 4, v.seed);
+        });
+        check("IndexCipher::applyRange", v, data);
+
+        data = makeInput(v, 4);
+        IndexEncryption().encryptInPlace(data.data(), data.size());
+        check("IndexEncryption::encryptInPlace", v, data);
+
+        data = makeInput(v, 4);
+        IndexEncryption enc;
+        forEachChunk(data, v.size - 4, [&](uint8_t* chunk, size_t position, size_t size) {
+            enc.decryptRange(chunk, position, size, v.seed);
+        });
+        check("IndexEncryption::decryptRange", v, data);
+    }
+}
+
+} // namespace
+
+int main() {
+    testGr();
+    testDat();
+    testIndex();
+
+    if (g_failures != 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("All cipher vectors match\n");
+    return 0;
+}
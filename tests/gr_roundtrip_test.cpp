@@ -0,0 +1,220 @@
+﻿// GR编码的回归测试。
+// 1. 解压tests/data/gr中的样本后用GrLevel::Original重新压缩，结果必须与样本逐字节相同。
+//    样本由Okumura lzss.c（帧改为以0填充）压缩一张小BMP、一段脚本文本和混合数据得到。
+// 2. 0~19字节的边界大小：Original的输出与同一参考编码器冻结的大小和FNV-1a 32位哈希比较，并能解压回原数据。
+// 3. Greedy/Optimal在多线程压缩时输出必须与单线程逐字节相同（bmp2gr -j依赖这一点）。
+// 用法：gr_roundtrip_test <样本目录>
+
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "core/compression/gr_lzss.h"
+
+using namespace eagls::compression;
+
+namespace {
+
+enum class Pattern {
+    Counter,  // data[i] = i * 131 + 17，几乎没有匹配
+    Period3,  // "abcabc..."，与自身重叠的匹配
+    Zeros,    // 全0，匹配到初始帧中的0
+};
+
+struct Vector {
+    Pattern pattern;    // 输入内容
+    size_t size;        // 输入大小
+    size_t encodedSize; // 参考编码器输出的大小
+    uint32_t hash;      // 参考编码器输出的FNV-1a哈希
+};
+
+const Vector EDGE_VECTORS[] = {
+    {Pattern::Counter, 0, 0, 0x811C9DC5},
+    {Pattern::Counter, 1, 2, 0xFC743827},
+    {Pattern::Counter, 2, 3, 0xC371A277},
+    {Pattern::Counter, 3, 4, 0x826EAC8C},
+    {Pattern::Counter, 4, 5, 0x4A3C098A},
+    {Pattern::Counter, 5, 6, 0xD6CC2425},
+    {Pattern::Counter, 6, 7, 0x7309817F},
+    {Pattern::Counter, 7, 8, 0x1B9EDB94},
+    {Pattern::Counter, 8, 9, 0x255C2036},
+    {Pattern::Counter, 9, 11, 0xCB91A9F4},
+    {Pattern::Counter, 10, 12, 0x77BB8DBA},
+    {Pattern::Counter, 11, 13, 0x7444A87B},
+    {Pattern::Counter, 12, 14, 0x4B7ACF53},
+    {Pattern::Counter, 13, 15, 0x29557F42},
+    {Pattern::Counter, 14, 16, 0xAF9964AE},
+    {Pattern::Counter, 15, 17, 0x8A8A98CF},
+    {Pattern::Counter, 16, 18, 0x4A37FD63},
+    {Pattern::Counter, 17, 20, 0x677B3E05},
+    {Pattern::Counter, 18, 21, 0x33721155},
+    {Pattern::Counter, 19, 22, 0xB2973AEA},
+    {Pattern::Period3, 0, 0, 0x811C9DC5},
+    {Pattern::Period3, 1, 2, 0x4C74B617},
+    {Pattern::Period3, 2, 3, 0x91E9A811},
+    {Pattern::Period3, 3, 4, 0xB167BF32},
+    {Pattern::Period3, 4, 5, 0x59F593C1},
+    {Pattern::Period3, 5, 6, 0x8C563AA9},
+    {Pattern::Period3, 6, 6, 0xACB5072C},
+    {Pattern::Period3, 7, 6, 0xADB508BF},
+    {Pattern::Period3, 8, 6, 0xAEB50A52},
+    {Pattern::Period3, 9, 6, 0xAFB50BE5},
+    {Pattern::Period3, 10, 6, 0xA8B500E0},
+    {Pattern::Period3, 11, 6, 0xA9B50273},
+    {Pattern::Period3, 12, 6, 0xAAB50406},
+    {Pattern::Period3, 13, 6, 0xABB50599},
+    {Pattern::Period3, 14, 6, 0xB4B513C4},
+    {Pattern::Period3, 15, 6, 0xB5B51557},
+    {Pattern::Period3, 16, 6, 0xB6B516EA},
+    {Pattern::Period3, 17, 6, 0xB7B5187D},
+    {Pattern::Period3, 18, 6, 0xB0B50D78},
+    {Pattern::Period3, 19, 6, 0xB1B50F0B},
+    {Pattern::Zeros, 0, 0, 0x811C9DC5},
+    {Pattern::Zeros, 1, 2, 0xEB741D64},
+    {Pattern::Zeros, 2, 3, 0x8997AB02},
+    {Pattern::Zeros, 3, 3, 0xB445E92B},
+    {Pattern::Zeros, 4, 3, 0xB345E798},
+    {Pattern::Zeros, 5, 3, 0xB645EC51},
+    {Pattern::Zeros, 6, 3, 0xB545EABE},
+    {Pattern::Zeros, 7, 3, 0xB845EF77},
+    {Pattern::Zeros, 8, 3, 0xB745EDE4},
+    {Pattern::Zeros, 9, 3, 0xBA45F29D},
+    {Pattern::Zeros, 10, 3, 0xB945F10A},
+    {Pattern::Zeros, 11, 3, 0xAC45DC93},
+    {Pattern::Zeros, 12, 3, 0xAB45DB00},
+    {Pattern::Zeros, 13, 3, 0xAE45DFB9},
+    {Pattern::Zeros, 14, 3, 0xAD45DE26},
+    {Pattern::Zeros, 15, 3, 0xB045E2DF},
+    {Pattern::Zeros, 16, 3, 0xAF45E14C},
+    {Pattern::Zeros, 17, 3, 0xB245E605},
+    {Pattern::Zeros, 18, 3, 0xB145E472},
+    {Pattern::Zeros, 19, 4, 0x63DBC6C4},
+};
+
+const char* const SAMPLES[] = { "bitmap.gr", "script.gr", "mixed.gr" };
+
+// 多线程压缩按64KB以上的块切分，输入至少要能切成这么多块
+constexpr size_t PARALLEL_INPUT_SIZE = 640 * 1024;
+const int THREAD_COUNTS[] = { 2, 3, 4, 8, 0 };
+
+int g_failures = 0;
+
+uint32_t fnv1a(const std::vector<uint8_t>& data) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t b : data) {
+        hash = (hash ^ b) * 16777619u;
+    }
+    return hash;
+}
+
+std::vector<uint8_t> makeInput(Pattern pattern, size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        switch (pattern) {
+        case Pattern::Counter: data[i] = static_cast<uint8_t>(i * 131 + 17); break;
+        case Pattern::Period3: data[i] = static_cast<uint8_t>('a' + i % 3); break;
+        case Pattern::Zeros:   data[i] = 0; break;
+        }
+    }
+    return data;
+}
+
+std::vector<uint8_t> readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::vector<uint8_t> encode(const std::vector<uint8_t>& data, GrLevel level, int threadCount) {
+    GrLzss lzss;
+    lzss.setLevel(level);
+    lzss.setThreadCount(threadCount);
+    return lzss.encode(data);
+}
+
+void testSamples(const std::string& folder, std::vector<uint8_t>& decodedSamples) {
+    for (const char* name : SAMPLES) {
+        const std::string filename = folder + "/" + name;
+        const std::vector<uint8_t> sample = readFile(filename);
+        if (sample.empty()) {
+            std::printf("FAIL cannot read sample %s\n", filename.c_str());
+            ++g_failures;
+            continue;
+        }
+
+        const std::vector<uint8_t> decoded = GrLzss().decode(sample);
+        const std::vector<uint8_t> encoded = encode(decoded, GrLevel::Original, 1);
+        if (encoded != sample) {
+            std::printf("FAIL Original round trip %s: %zu bytes, expected %zu\n", name, encoded.size(), sample.size());
+            ++g_failures;
+        }
+        decodedSamples.insert(decodedSamples.end(), decoded.begin(), decoded.end());
+    }
+}
+
+void testEdgeSizes() {
+    for (const Vector& v : EDGE_VECTORS) {
+        const std::vector<uint8_t> input = makeInput(v.pattern, v.size);
+        const std::vector<uint8_t> encoded = encode(input, GrLevel::Original, 1);
+        const uint32_t hash = fnv1a(encoded);
+        if (encoded.size() != v.encodedSize || hash != v.hash) {
+            std::printf("FAIL Original pattern=%d size=%zu: %zu bytes 0x%08X, expected %zu bytes 0x%08X\n",
+                        static_cast<int>(v.pattern), v.size, encoded.size(), hash, v.encodedSize, v.hash);
+            ++g_failures;
+        }
+        if (GrLzss().decode(encoded) != input) {
+            std::printf("FAIL decode pattern=%d size=%zu\n", static_cast<int>(v.pattern), v.size);
+            ++g_failures;
+        }
+    }
+}
+
+void testThreadDeterminism(const std::vector<uint8_t>& decodedSamples) {
+    // 重复样本内容并夹入伪随机段，使各块边界落在不同类型的数据上
+    std::vector<uint8_t> input;
+    input.reserve(PARALLEL_INPUT_SIZE);
+    uint32_t state = 12345;
+    while (input.size() < PARALLEL_INPUT_SIZE) {
+        input.insert(input.end(), decodedSamples.begin(), decodedSamples.end());
+        for (size_t i = 0; i < 7777; ++i) {
+            state = state * 1103515245u + 12345u;
+            input.push_back(static_cast<uint8_t>(state >> 16));
+        }
+    }
+
+    for (GrLevel level : { GrLevel::Greedy, GrLevel::Optimal }) {
+        const std::vector<uint8_t> single = encode(input, level, 1);
+        if (GrLzss().decode(single) != input) {
+            std::printf("FAIL decode level=%d\n", static_cast<int>(level));
+            ++g_failures;
+        }
+        for (int threadCount : THREAD_COUNTS) {
+            if (encode(input, level, threadCount) != single) {
+                std::printf("FAIL level=%d threads=%d differs from 1 thread\n", static_cast<int>(level), threadCount);
+                ++g_failures;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::printf("Usage: gr_roundtrip_test <sample folder>\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> decodedSamples;
+    testSamples(argv[1], decodedSamples);
+    testEdgeSizes();
+    testThreadDeterminism(decodedSamples);
+
+    if (g_failures != 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("All GR round trips match\n");
+    return 0;
+}